@@ -1,286 +1,5618 @@
 #include <iostream>
-#include <fstream>
 #include <sstream>
 #include <string>
 #include <vector>
-#include <set>
 #include <unordered_map>
+#include <array>
+#include <charconv>
 #include <optional>
 #include <algorithm>
+#include <cstdint>
 #include <random>
+#include <memory>
+#include <cmath>
 #include <cassert>
+#include <stdexcept>
+#include <cerrno>
+#include <cstring>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <fstream>
+#include <iomanip>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#ifdef SAT_USE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef SAT_USE_LZMA
+#include <lzma.h>
+#endif
+#ifdef SAT_USE_BZIP2
+#include <bzlib.h>
+#endif
+// AVX2 kernels need GCC or Clang on x86-64; -DSAT_NO_SIMD leaves only the scalar ones.
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__)) && !defined(SAT_NO_SIMD)
+#define SAT_AVX2 1
+#include <immintrin.h>
+#endif
 
 using namespace std;
 
+// A literal packed into 32 bits as 2 * variable + negation, so that a literal and its
+// negation are adjacent and the code itself indexes per-literal tables.
 struct Literal {
-    int variable;
-    bool negation;
+    uint32_t code;
+
+    Literal() : code(0) {}
+    Literal(int var, bool neg) : code(2 * static_cast<uint32_t>(var) + (neg ? 1 : 0)) {}
+
+    int variable() const {
+        return static_cast<int>(code >> 1);
+    }
 
-    Literal(int var, bool neg) : variable(var), negation(neg) {}
+    bool negation() const {
+        return code & 1;
+    }
 
     Literal neg() const {
-        return Literal(variable, !negation);
+        Literal lit;
+        lit.code = code ^ 1;
+        return lit;
     }
 
     string to_string() const {
-        return negation ? "¬" + std::to_string(variable) : std::to_string(variable);
+        return negation() ? "¬" + std::to_string(variable()) : std::to_string(variable());
+    }
+
+    int to_dimacs() const {
+        return negation() ? -variable() : variable();
     }
 
     bool operator==(const Literal& other) const {
-        return variable == other.variable && negation == other.negation;
+        return code == other.code;
+    }
+
+    bool operator!=(const Literal& other) const {
+        return code != other.code;
+    }
+
+    // Dense index used for per-literal tables such as watch lists.
+    size_t index() const {
+        return code;
     }
 };
 
+// Offset of a clause header inside ClauseArena::memory.
+using ClauseRef = uint32_t;
+
+// Reason recorded for decisions: the assignment has no antecedent clause.
+const ClauseRef NO_REASON = UINT32_MAX;
+
+// Clause header, stored inline in the arena and immediately followed by its literals.
 struct Clause {
-    vector<Literal> literals;
+    uint32_t length;
+    uint32_t learnt : 1;
+    uint32_t removed : 1;    // deleted from the database, words reclaimed by the next compaction
+    uint32_t used : 2;       // recently involved in conflict analysis, decays at each reduction
+    uint32_t vivified : 1;   // already tried by vivification
+    uint32_t lbd : 27;
+    union {
+        float activity;
+        ClauseRef forward;   // during a compaction: the reference the clause is moving to
+    };
 
-    Clause(const vector<Literal>& lits) : literals(lits) {}
+    Clause(const Clause&) = delete;
+    Clause& operator=(const Clause&) = delete;
 
     size_t size() const {
-        return literals.size();
+        return length;
+    }
+
+    Literal* begin() {
+        return reinterpret_cast<Literal*>(this + 1);
+    }
+
+    Literal* end() {
+        return begin() + length;
+    }
+
+    const Literal* begin() const {
+        return reinterpret_cast<const Literal*>(this + 1);
+    }
+
+    const Literal* end() const {
+        return begin() + length;
+    }
+
+    Literal& operator[](size_t i) {
+        return begin()[i];
+    }
+
+    const Literal& operator[](size_t i) const {
+        return begin()[i];
     }
 
     string to_string() const {
         stringstream ss;
-        for (size_t i = 0; i < literals.size(); ++i) {
+        for (size_t i = 0; i < size(); ++i) {
             if (i > 0) ss << " ∨ ";
-            ss << literals[i].to_string();
+            ss << (*this)[i].to_string();
         }
         return ss.str();
     }
 };
 
-struct Formula {
-    vector<Clause> clauses;
-    set<int> variables;
+static_assert(sizeof(Literal) == sizeof(uint32_t), "literals must pack into one arena word");
+static_assert(sizeof(Clause) % sizeof(uint32_t) == 0, "clause headers must be word aligned");
+
+// All clauses live back to back in one buffer of 32-bit words and are addressed by offset.
+// Allocation bumps the end of the buffer; removed clauses and the tails of shrunk ones stay
+// in place until compact() slides the live clauses down over them, so the buffer never
+// has to be given back and reallocated. References stay valid across growth; Clause& does
+// not, so re-resolve after alloc().
+class ClauseArena {
+public:
+    static constexpr size_t HEADER_WORDS = sizeof(Clause) / sizeof(uint32_t);
+    static constexpr uint32_t PADDING = UINT32_MAX;  // fills the tail of a shrunk clause; no header starts so
+
+    vector<uint32_t> memory;
+    size_t wasted = 0;  // words held by removed clauses and shrunk tails
+
+    template <typename Lits>
+    ClauseRef alloc(const Lits& lits, bool learnt) {
+        ClauseRef ref = open_clause(learnt);
+        for (const Literal& lit : lits) push_literal(lit);
+        close_clause(ref);
+        return ref;
+    }
 
-    Formula(const vector<Clause>& cls) : clauses(cls) {
-        for (const Clause& clause : clauses) {
-            for (const Literal& lit : clause.literals) {
-                variables.insert(lit.variable);
+    // Incremental construction, used by the parser to write literals straight into the arena.
+    ClauseRef open_clause(bool learnt) {
+        ClauseRef ref = static_cast<ClauseRef>(memory.size());
+        memory.resize(memory.size() + HEADER_WORDS);
+        Clause& clause = (*this)[ref];
+        clause.length = 0;
+        clause.learnt = learnt;
+        clause.removed = 0;
+        clause.used = 0;
+        clause.vivified = 0;
+        clause.lbd = 0;
+        clause.activity = 0;
+        return ref;
+    }
+
+    void push_literal(Literal lit) {
+        memory.push_back(lit.code);
+    }
+
+    void close_clause(ClauseRef ref) {
+        (*this)[ref].length = static_cast<uint32_t>(memory.size() - ref - HEADER_WORDS);
+    }
+
+    void free(ClauseRef ref) {
+        Clause& clause = (*this)[ref];
+        clause.removed = 1;
+        wasted += HEADER_WORDS + clause.size();
+    }
+
+    // Cuts the clause behind ref down to its first size literals.
+    void shrink(ClauseRef ref, size_t size) {
+        Clause& clause = (*this)[ref];
+        fill(memory.begin() + ref + HEADER_WORDS + size, memory.begin() + ref + HEADER_WORDS + clause.size(), PADDING);
+        wasted += clause.size() - size;
+        clause.length = static_cast<uint32_t>(size);
+    }
+
+    // Compaction runs in two steps around rewriting the references held elsewhere. The plan
+    // gives every live clause the reference it will have, read back through forward().
+    void plan_compaction() {
+        activities.clear();
+        ClauseRef to = 0;
+        for (ClauseRef from = skip_padding(0); from < memory.size(); from = skip_padding(from + words(from))) {
+            Clause& clause = (*this)[from];
+            if (clause.removed) continue;
+            activities.push_back(clause.activity);
+            clause.forward = to;
+            to += static_cast<ClauseRef>(words(from));
+        }
+    }
+
+    // Where the clause at ref moves in the planned compaction, or NO_REASON if it is removed.
+    ClauseRef forward(ClauseRef ref) const {
+        const Clause& clause = (*this)[ref];
+        return clause.removed ? NO_REASON : clause.forward;
+    }
+
+    // Slides the live clauses down over the free words, keeping their order, as planned.
+    void compact() {
+        size_t to = 0;
+        size_t live = 0;
+        for (size_t from = skip_padding(0); from < memory.size();) {
+            size_t length = words(static_cast<ClauseRef>(from));
+            if (!(*this)[static_cast<ClauseRef>(from)].removed) {
+                copy(memory.begin() + from, memory.begin() + from + length, memory.begin() + to);
+                (*this)[static_cast<ClauseRef>(to)].activity = activities[live++];
+                to += length;
             }
+            from = skip_padding(from + length);
+        }
+        memory.resize(to);
+        wasted = 0;
+    }
+
+    size_t size() const {
+        return memory.size();
+    }
+
+    Clause& operator[](ClauseRef ref) {
+        return *reinterpret_cast<Clause*>(&memory[ref]);
+    }
+
+    const Clause& operator[](ClauseRef ref) const {
+        return *reinterpret_cast<const Clause*>(&memory[ref]);
+    }
+
+    void reserve(size_t words) {
+        memory.reserve(words);
+    }
+
+    void clear() {
+        memory.clear();
+        wasted = 0;
+    }
+
+private:
+    vector<float> activities;  // of the live clauses during a compaction, whose headers hold forward
+
+    size_t words(ClauseRef ref) const {
+        return HEADER_WORDS + (*this)[ref].size();
+    }
+
+    size_t skip_padding(size_t at) const {
+        while (at < memory.size() && memory[at] == PADDING) ++at;
+        return at;
+    }
+};
+
+struct Formula {
+    ClauseArena arena;
+    vector<ClauseRef> clauses;  // original clauses; learned ones are owned by ClauseDatabase
+    vector<uint8_t> occurs;     // occurs[var] is set once var appears in some clause
+    size_t variable_count;
+
+    int max_variable;
+
+    Formula() : variable_count(0), max_variable(0) {}
+
+    // Drops every clause and variable, keeping the allocations for the next formula.
+    void clear() {
+        arena.clear();
+        clauses.clear();
+        occurs.clear();
+        variable_count = 0;
+        max_variable = 0;
+    }
+
+    void note_variable(int var) {
+        if (static_cast<size_t>(var) >= occurs.size()) occurs.resize(max<size_t>(2 * occurs.size(), var + 1), 0);
+        if (!occurs[var]) {
+            occurs[var] = 1;
+            ++variable_count;
+            max_variable = max(max_variable, var);
         }
     }
 
-    set<int> get_variables() const {
-        return variables;
+    ClauseRef add_clause(const vector<Literal>& lits) {
+        for (const Literal& lit : lits) note_variable(lit.variable());
+        ClauseRef ref = arena.alloc(lits, false);
+        clauses.push_back(ref);
+        return ref;
+    }
+
+    Clause& clause(ClauseRef ref) {
+        return arena[ref];
+    }
+
+    const Clause& clause(ClauseRef ref) const {
+        return arena[ref];
+    }
+
+    vector<int> get_variables() const {
+        vector<int> vars;
+        vars.reserve(variable_count);
+        for (size_t var = 0; var < occurs.size(); ++var) {
+            if (occurs[var]) vars.push_back(static_cast<int>(var));
+        }
+        return vars;
     }
 
     string to_string() const {
         stringstream ss;
         for (size_t i = 0; i < clauses.size(); ++i) {
             if (i > 0) ss << " ∧ ";
-            ss << "(" << clauses[i].to_string() << ")";
+            ss << "(" << arena[clauses[i]].to_string() << ")";
         }
         return ss.str();
     }
 };
 
-struct Assignment {
-    bool value;
-    optional<Clause> antecedent;
-    int dl;  // decision level
-
-    Assignment(bool val, optional<Clause> ant, int decision_level)
-        : value(val), antecedent(ant), dl(decision_level) {}
+// Literal scanning kernels over the packed value array of Assignments, one byte per variable:
+// 1 true, 0 false, -1 unassigned, and over clause signatures. The AVX2 versions gather eight
+// values, or four signatures, at once; they are compiled for that target alone and chosen at
+// run time when the CPU has AVX2, so the binary still runs anywhere. Other CPUs, ARM included,
+// whose NEON has no gather, use the scalar loops, as do inputs too short to fill a vector.
+struct LiteralScan {
+    bool satisfied;      // some literal is true
+    uint32_t falsified;  // false literals, only counted up to the first true one
 };
 
+inline LiteralScan scan_literals_scalar(const Literal* lits, size_t n, const int8_t* values) {
+    uint32_t falsified = 0;
+    for (size_t i = 0; i < n; ++i) {
+        int8_t value = values[lits[i].variable()];
+        if (value < 0) continue;
+        if (value != static_cast<int8_t>(lits[i].negation())) return {true, falsified};
+        ++falsified;
+    }
+    return {false, falsified};
+}
+
+#ifdef SAT_AVX2
+bool detect_avx2() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+
+const bool HAS_AVX2 = detect_avx2();
+
+// The truth of eight literals, 1 true, 0 false, and 0xfe or 0xff unassigned. Values are
+// gathered as the aligned 32-bit words holding them, which stay inside the array because
+// Assignments pads it to a whole number of words.
+__attribute__((target("avx2"))) inline __m256i gather_truth(const Literal* lits, const int8_t* values) {
+    __m256i codes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lits));
+    __m256i vars = _mm256_srli_epi32(codes, 1);
+    __m256i words = _mm256_i32gather_epi32(reinterpret_cast<const int*>(values), _mm256_srli_epi32(vars, 2), 4);
+    __m256i shift = _mm256_slli_epi32(_mm256_and_si256(vars, _mm256_set1_epi32(3)), 3);
+    __m256i value = _mm256_and_si256(_mm256_srlv_epi32(words, shift), _mm256_set1_epi32(0xff));
+    return _mm256_xor_si256(value, _mm256_and_si256(codes, _mm256_set1_epi32(1)));
+}
+
+__attribute__((target("avx2"))) inline unsigned lanes_equal(__m256i truth, int expected) {
+    return static_cast<unsigned>(
+        _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(truth, _mm256_set1_epi32(expected)))));
+}
+
+__attribute__((target("avx2"))) LiteralScan scan_literals_avx2(const Literal* lits, size_t n, const int8_t* values) {
+    uint32_t falsified = 0;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i truth = gather_truth(lits + i, values);
+        unsigned falses = lanes_equal(truth, 0);
+        if (unsigned trues = lanes_equal(truth, 1)) {
+            // As in the scalar loop, only the false literals before the first true one count.
+            unsigned before = (trues & (0u - trues)) - 1;
+            return {true, falsified + static_cast<uint32_t>(__builtin_popcount(falses & before))};
+        }
+        falsified += static_cast<uint32_t>(__builtin_popcount(falses));
+    }
+    LiteralScan tail = scan_literals_scalar(lits + i, n - i, values);
+    return {tail.satisfied, falsified + tail.falsified};
+}
+#endif
+
+inline LiteralScan scan_literals(const Literal* lits, size_t n, const int8_t* values) {
+#ifdef SAT_AVX2
+    if (n >= 8 && HAS_AVX2) return scan_literals_avx2(lits, n, values);
+#endif
+    return scan_literals_scalar(lits, n, values);
+}
+
+// Keeps the clause ids whose signature has every bit of required set, in order: the only
+// clauses a clause with signature required can subsume or strengthen.
+inline void filter_signatures_scalar(vector<uint32_t>& ids, const uint64_t* signatures, uint64_t required) {
+    auto misses = [&](uint32_t id) { return (required & ~signatures[id]) != 0; };
+    ids.erase(remove_if(ids.begin(), ids.end(), misses), ids.end());
+}
+
+#ifdef SAT_AVX2
+__attribute__((target("avx2"))) void filter_signatures_avx2(vector<uint32_t>& ids, const uint64_t* signatures,
+                                                            uint64_t required) {
+    __m256i wanted = _mm256_set1_epi64x(static_cast<long long>(required));
+    size_t kept = 0, i = 0;
+    for (; i + 4 <= ids.size(); i += 4) {
+        __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&ids[i]));
+        __m256i found = _mm256_i32gather_epi64(reinterpret_cast<const long long*>(signatures), group, 8);
+        __m256i missing = _mm256_andnot_si256(found, wanted);
+        unsigned pass = static_cast<unsigned>(
+            _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(missing, _mm256_setzero_si256()))));
+        for (unsigned lane = 0; lane < 4; ++lane) {
+            if (pass & (1u << lane)) ids[kept++] = ids[i + lane];
+        }
+    }
+    for (; i < ids.size(); ++i) {
+        if (!(required & ~signatures[ids[i]])) ids[kept++] = ids[i];
+    }
+    ids.resize(kept);
+}
+#endif
+
+inline void filter_signatures(vector<uint32_t>& ids, const uint64_t* signatures, uint64_t required) {
+#ifdef SAT_AVX2
+    if (ids.size() >= 8 && HAS_AVX2) return filter_signatures_avx2(ids, signatures, required);
+#endif
+    filter_signatures_scalar(ids, signatures, required);
+}
+
 class Assignments {
 public:
-    unordered_map<int, Assignment> assignments;
-    int dl;
+    // Dense per-variable state, indexed by variable number.
+    vector<int8_t> values;    // 1 = true, 0 = false, -1 = unassigned; padded to whole 32-bit
+                              // words with unassigned entries, for the gathers of the AVX2 kernels
+    vector<int> levels;       // decision level of each assigned variable, which chronological
+                              // backtracking can leave below the levels of earlier trail entries
+    vector<ClauseRef> reasons; // antecedent clause in the arena, or NO_REASON
+    vector<int8_t> saved_phases; // last value of each variable, recorded when backtrack undoes it
+    vector<Literal> trail;    // true literals in assignment order
+    vector<size_t> trail_lim; // trail_lim[l - 1] is where decision level l starts on the trail
+    size_t qhead;             // first trail entry not yet propagated
+
+    Assignments(int max_variable)
+        : values(padded(max_variable + 1), -1), levels(max_variable + 1, 0), reasons(max_variable + 1, NO_REASON),
+          saved_phases(max_variable + 1, 0), qhead(0) {
+        trail.reserve(max_variable);
+    }
+
+    // Makes room for variables up to max_variable, which start unassigned.
+    void resize(int max_variable) {
+        size_t size = static_cast<size_t>(max_variable) + 1;
+        if (size <= levels.size()) return;
+        values.resize(padded(size), -1);
+        levels.resize(size, 0);
+        reasons.resize(size, NO_REASON);
+        saved_phases.resize(size, 0);
+    }
+
+    // Unassigns every variable and forgets the saved phases; the tables keep their size.
+    void clear() {
+        fill(values.begin(), values.end(), -1);
+        fill(levels.begin(), levels.end(), 0);
+        fill(reasons.begin(), reasons.end(), NO_REASON);
+        fill(saved_phases.begin(), saved_phases.end(), 0);
+        trail.clear();
+        trail_lim.clear();
+        qhead = 0;
+    }
 
-    Assignments() : dl(0) {}
+    int decision_level() const {
+        return static_cast<int>(trail_lim.size());
+    }
+
+    void new_decision_level() {
+        trail_lim.push_back(trail.size());
+    }
 
     bool value(const Literal& literal) const {
-        auto it = assignments.find(literal.variable);
-        if (it == assignments.end()) return false;
-        return literal.negation ? !it->second.value : it->second.value;
+        return values[literal.variable()] == (literal.negation() ? 0 : 1);
+    }
+
+    bool is_assigned(int variable) const {
+        return values[variable] >= 0;
+    }
+
+    bool falsified(const Literal& literal) const {
+        return values[literal.variable()] == (literal.negation() ? 1 : 0);
+    }
+
+    int level(int variable) const {
+        return levels[variable];
+    }
+
+    ClauseRef reason(int variable) const {
+        return reasons[variable];
+    }
+
+    void assign(int variable, bool value, ClauseRef antecedent) {
+        assign(variable, value, antecedent, decision_level());
     }
 
-    void assign(int variable, bool value, const optional<Clause>& antecedent) {
-        assignments[variable] = Assignment(value, antecedent, dl);
+    // Assigns at level, the highest level among the antecedent's other literals; below the
+    // current level this is an out-of-order assignment.
+    void assign(int variable, bool value, ClauseRef antecedent, int level) {
+        values[variable] = value ? 1 : 0;
+        levels[variable] = level;
+        reasons[variable] = antecedent;
+        trail.push_back(Literal(variable, !value));
     }
 
     void unassign(int variable) {
-        assignments.erase(variable);
+        values[variable] = -1;
+        reasons[variable] = NO_REASON;
     }
 
     bool satisfy(const Formula& formula) const {
-        for (const Clause& clause : formula.clauses) {
-            bool clause_satisfied = false;
-            for (const Literal& lit : clause.literals) {
-                if (value(lit)) {
-                    clause_satisfied = true;
-                    break;
-                }
-            }
-            if (!clause_satisfied) return false;
+        for (ClauseRef ref : formula.clauses) {
+            const Clause& clause = formula.clause(ref);
+            if (!scan_literals(clause.begin(), clause.size(), values.data()).satisfied) return false;
         }
         return true;
     }
 
     size_t size() const {
-        return assignments.size();
+        return trail.size();
+    }
+
+private:
+    static size_t padded(size_t size) {
+        return (size + 3) & ~static_cast<size_t>(3);
     }
 };
 
-bool all_variables_assigned(const Formula& formula, const Assignments& assignments) {
-    return formula.get_variables().size() == assignments.size();
-}
+enum class PhaseMode {
+    SAVED,         // reuse the value a variable had when it was last unassigned
+    ALWAYS_FALSE,  // always decide false
+    TARGET,        // follow the longest conflict-free trail seen, falling back to saved phases
+};
+
+enum class RestartMode {
+    NONE,
+    LUBY,       // restart_base * luby(i) conflicts between restarts
+    GEOMETRIC,  // restart_base * restart_factor^i conflicts between restarts
+    GLUCOSE,    // restart when recent learned clauses have a markedly worse LBD than average
+};
+
+enum class ProofFormat {
+    DRAT_BINARY,  // the compact binary DRAT encoding read by drat-trim
+    DRAT_TEXT,
+    LRAT,         // text LRAT: numbered clauses with the hints of every derivation
+};
+
+enum class Engine {
+    FULL,  // every feature behind its runtime switch
+    LEAN,  // glucose restarts, no proof logging and no search statistics, compiled in
+};
+
+struct SolverOptions {
+    uint32_t seed = 0;
+    double var_decay = 0.95;           // EVSIDS: the bump increment grows by 1 / var_decay per conflict
+    double random_branch_freq = 0.0;   // probability of a random decision instead of the heap top
+    PhaseMode phase_mode = PhaseMode::SAVED;
+    uint64_t rephase_interval = 1000;  // conflicts before the first rephase, growing linearly; 0 disables
+    RestartMode restart_mode = RestartMode::GLUCOSE;
+    uint64_t restart_base = 100;       // first restart interval for LUBY and GEOMETRIC, in conflicts
+    double restart_factor = 1.5;       // interval growth for GEOMETRIC
+    uint64_t reduce_interval = 2000;   // conflicts before the first learned clause reduction
+    uint64_t reduce_increment = 300;   // growth of the reduction interval after each reduction
+    unsigned core_lbd = 2;             // learned clauses up to this LBD are kept forever
+    unsigned tier2_lbd = 6;            // up to this LBD clauses survive while they keep being used
+    double clause_decay = 0.999;
+    bool minimize_learned = true;      // recursive minimization of first-UIP clauses
+    unsigned chrono = 100;             // backjumps over more levels than this go back one level only; 0 disables
+    bool preprocess = true;            // subsumption and bounded variable elimination before search
+    uint64_t preprocess_steps = 30000000;  // effort budget of the preprocessor, in literal visits
+    bool probe = true;                 // failed-literal probing on binary implications before search
+    uint64_t probe_steps = 10000000;   // effort budget of probing, in watcher visits
+    bool inprocess = true;             // periodic probing, equivalence substitution and vivification
+    uint64_t inprocess_interval = 5000;  // conflicts before the first inprocessing round, growing linearly
+    double probe_effort = 0.05;        // inprocessing budgets, as fractions of the propagation ticks
+    double substitute_effort = 0.05;   // spent on search since the previous round
+    double vivify_effort = 0.1;
+    bool walk = true;                  // local search from the saved phases at every rephase
+    double walk_effort = 0.5;          // its budget, as a fraction of the propagation ticks since the last walk
+    unsigned threads = 1;              // portfolio workers racing on private copies of the formula
+    bool share = true;                 // exchange learned clauses between portfolio workers
+    size_t share_size = 8;             // longest learned clause published to the other workers
+    unsigned share_lbd = 2;            // and its highest LBD
+    uint64_t max_conflicts = 0;        // give up with UNKNOWN after this many conflicts; 0 means no limit
+    double time_limit = 0;             // and after this many seconds of one solve call
+    uint64_t mem_limit = 0;            // and once the process has held this many MiB resident
+    Engine engine = Engine::FULL;      // compiled solver configuration, see FullConfig
+    uint16_t cube_port = 0;            // serve cubes to workers on this port (cube-and-conquer server)
+    string cube_server;                // "host:port" of the cube server to work for
+    unsigned cube_depth = 10;          // split decisions per cube, so up to 2^depth cubes
+    uint64_t cube_conflicts = 10000;   // conflicts a worker spends on a cube before asking to split it
+    string proof_file;                 // write a proof of unsatisfiability here
+    ProofFormat proof_format = ProofFormat::DRAT_BINARY;
+    double progress = 0;               // seconds between progress lines on stderr; 0 disables them
+    bool timers = false;               // time propagation, analysis, reduction and simplification
+    string stats_file;                 // write the statistics of every solver here as JSON at exit
+    string snapshot_file;              // write the solver state here after preprocessing, and on giving up
+    string resume_file;                // start from this snapshot instead of the clauses given
+    string model_file;                 // write the model here instead of to standard output
+    bool verify = false;               // check a model against the input clauses before reporting it
+    string bench;                      // benchmark the CNF files of this directory or list file
+    double bench_timeout = 60;         // wall-clock seconds per benchmark instance
+    uint64_t bench_memory = 0;         // address-space cap per benchmark instance in MiB; 0 means none
+    string bench_output;               // benchmark results, as JSON if the name ends in .json and CSV otherwise
+    string bench_baseline;             // earlier benchmark results to compare with
+    string batch;                      // solve the CNF files of this directory or list file in one process
+    unsigned jobs = 0;                 // batch worker threads; 0 means one per hardware thread
+    string batch_output;               // batch results, streamed as they finish; standard output if empty
+};
+
+// Decision polarities on top of the saved phases kept in Assignments: target phases taken
+// from the longest conflict-free trail, and periodic rephasing that overwrites the saved
+// phases to move the search to a different region.
+class Phases {
+public:
+    vector<int8_t> target;  // -1 where no target is known
+    size_t target_size;
+    uint64_t next_rephase;
+    uint64_t rephase_count;
+
+    Phases(int max_variable, const SolverOptions& options)
+        : target(max_variable + 1, -1), target_size(0), next_rephase(options.rephase_interval), rephase_count(0) {}
+
+    void resize(int max_variable) {
+        if (static_cast<size_t>(max_variable) + 1 > target.size()) target.resize(max_variable + 1, -1);
+    }
+
+    void clear(const SolverOptions& options) {
+        fill(target.begin(), target.end(), -1);
+        target_size = 0;
+        next_rephase = options.rephase_interval;
+        rephase_count = 0;
+    }
 
-pair<int, bool> pick_branching_variable(const Formula& formula, const Assignments& assignments) {
-    vector<int> unassigned_vars;
-    for (int var : formula.get_variables()) {
-        if (assignments.assignments.find(var) == assignments.assignments.end()) {
-            unassigned_vars.push_back(var);
+    // Records the trail prefix that was still conflict-free when it beats the current target.
+    void update_target(const Assignments& assignments, size_t consistent) {
+        if (consistent <= target_size) return;
+        for (size_t i = 0; i < consistent; ++i) {
+            const Literal& lit = assignments.trail[i];
+            target[lit.variable()] = lit.negation() ? 0 : 1;
         }
+        target_size = consistent;
     }
-    random_device rd;
-    mt19937 gen(rd());
-    uniform_int_distribution<> var_dist(0, unassigned_vars.size() - 1);
-    uniform_int_distribution<> val_dist(0, 1);
-    int var = unassigned_vars[var_dist(gen)];
-    bool val = val_dist(gen);
-    return {var, val};
-}
 
-void backtrack(Assignments& assignments, int b) {
-    vector<int> to_remove;
-    for (const auto& [var, assignment] : assignments.assignments) {
-        if (assignment.dl > b) {
-            to_remove.push_back(var);
+    bool polarity(int var, const Assignments& assignments, const SolverOptions& options) const {
+        switch (options.phase_mode) {
+            case PhaseMode::ALWAYS_FALSE:
+                return false;
+            case PhaseMode::TARGET:
+                if (target[var] >= 0) return target[var];
+                return assignments.saved_phases[var];
+            case PhaseMode::SAVED:
+            default:
+                return assignments.saved_phases[var];
         }
     }
-    for (int var : to_remove) {
-        assignments.unassign(var);
+
+    // Cycles the saved phases through best-known, all-false, all-true and random values; returns
+    // true if it rephased.
+    bool maybe_rephase(Assignments& assignments, uint64_t conflicts, const SolverOptions& options, mt19937& rng) {
+        if (options.rephase_interval == 0 || conflicts < next_rephase) return false;
+        vector<int8_t>& saved = assignments.saved_phases;
+        switch (rephase_count++ % 4) {
+            case 0:
+                for (size_t var = 0; var < saved.size(); ++var) {
+                    if (target[var] >= 0) saved[var] = target[var];
+                }
+                break;
+            case 1:
+                fill(saved.begin(), saved.end(), 0);
+                break;
+            case 2:
+                fill(saved.begin(), saved.end(), 1);
+                break;
+            case 3: {
+                uniform_int_distribution<> bit(0, 1);
+                for (int8_t& phase : saved) phase = static_cast<int8_t>(bit(rng));
+                break;
+            }
+        }
+        target_size = 0;
+        next_rephase = conflicts + options.rephase_interval * (rephase_count + 1);
+        return true;
     }
-}
+};
 
-pair<string, optional<Clause>> unit_propagation(const Formula& formula, Assignments& assignments) {
-    bool finish = false;
-    while (!finish) {
-        finish = true;
-        for (const Clause& clause : formula.clauses) {
-            int false_count = 0;
-            optional<Literal> unassigned_literal;
-            bool clause_satisfied = false;
-            for (const Literal& literal : clause.literals) {
-                if (assignments.assignments.find(literal.variable) == assignments.assignments.end()) {
-                    unassigned_literal = literal;
-                } else if (assignments.value(literal)) {
-                    clause_satisfied = true;
-                    break;
-                } else {
-                    ++false_count;
+// ProbSAT local search over the irredundant clauses, read in place from the arena. Variables
+// fixed at level 0 keep their value and clauses they satisfy are left out. Each step picks a
+// falsified clause at random and flips one of its variables, chosen with a probability that
+// falls steeply with the variable's break count: the clauses it alone satisfies. Break counts
+// are kept up to date from a true-literal count and the xor of the true variables per clause.
+class LocalSearch {
+public:
+    vector<int8_t> values;  // current assignment, by variable
+    vector<int8_t> best;    // assignment with the fewest falsified clauses seen
+    vector<uint8_t> fixed;  // assigned at level 0
+    uint64_t flips = 0;
+    uint64_t ticks = 0;     // occurrences and literals visited, the unit of the budget
+
+    LocalSearch(const Formula& formula, const Assignments& assignments, const vector<int8_t>& phases)
+        : values(phases), fixed(phases.size(), 0), formula(formula) {
+        size_t level0 = assignments.decision_level() > 0 ? assignments.trail_lim[0] : assignments.trail.size();
+        for (size_t i = 0; i < level0; ++i) {
+            int var = assignments.trail[i].variable();
+            values[var] = assignments.values[var];
+            fixed[var] = 1;
+        }
+
+        // Flattened occurrence lists: the clauses holding literal l are occurrences[starts[l]..starts[l + 1]).
+        starts.assign(2 * values.size() + 1, 0);
+        size_t literals = 0;
+        for (ClauseRef ref : formula.clauses) {
+            const Clause& clause = formula.clause(ref);
+            ticks += clause.size();
+            auto fixed_true = [&](const Literal& lit) { return fixed[lit.variable()] && satisfied(lit); };
+            if (any_of(clause.begin(), clause.end(), fixed_true)) continue;
+            clauses.push_back(ref);
+            literals += clause.size();
+            for (const Literal& lit : clause) {
+                if (!fixed[lit.variable()]) ++starts[lit.index() + 1];
+            }
+        }
+        for (size_t i = 1; i < starts.size(); ++i) starts[i] += starts[i - 1];
+        occurrences.resize(starts.back());
+        vector<uint32_t> next(starts.begin(), starts.end() - 1);
+        for (uint32_t c = 0; c < clauses.size(); ++c) {
+            for (const Literal& lit : formula.clause(clauses[c])) {
+                if (!fixed[lit.variable()]) occurrences[next[lit.index()]++] = c;
+            }
+        }
+
+        true_count.assign(clauses.size(), 0);
+        critical.assign(clauses.size(), 0);
+        position.assign(clauses.size(), UINT32_MAX);
+        breaks.assign(values.size(), 0);
+        for (uint32_t c = 0; c < clauses.size(); ++c) {
+            for (const Literal& lit : formula.clause(clauses[c])) {
+                if (!fixed[lit.variable()] && satisfied(lit)) {
+                    ++true_count[c];
+                    critical[c] ^= static_cast<uint32_t>(lit.variable());
                 }
             }
+            if (true_count[c] == 0) falsify(c);
+            if (true_count[c] == 1) ++breaks[critical[c]];
+        }
+        best = values;
+        best_unsat = unsat.size();
 
-            if (clause_satisfied) continue;
+        // Polynomial break scores for short clauses, exponential ones for longer (Balint and Schöning).
+        double average = clauses.empty() ? 0 : static_cast<double>(literals) / clauses.size();
+        double base = average <= 4 ? 2.85 : average <= 5 ? 3.7 : average <= 6 ? 5.1 : 7.4;
+        for (size_t b = 0; b < scores.size(); ++b) {
+            scores[b] = average <= 3.5 ? pow(1.0 + b, -2.38) : pow(base, -static_cast<double>(b));
+        }
+    }
+
+    size_t falsified() const {
+        return unsat.size();
+    }
 
-            if (false_count == clause.literals.size() - 1 && unassigned_literal.has_value()) {
-                assignments.assign(unassigned_literal->variable, !unassigned_literal->negation, clause);
-                finish = false;
-            } else if (false_count == clause.literals.size()) {
-                return {"conflict", clause};
+    // Flips until every clause is satisfied or budget ticks are spent; returns true on a model.
+    bool run(uint64_t budget, mt19937& rng) {
+        vector<pair<int, double>> candidates;
+        uniform_real_distribution<double> unit(0, 1);
+        while (!unsat.empty() && ticks < budget) {
+            const Clause& clause = formula.clause(clauses[unsat[rng() % unsat.size()]]);
+            ticks += clause.size();
+            candidates.clear();
+            double sum = 0;
+            for (const Literal& lit : clause) {
+                int var = lit.variable();
+                if (fixed[var]) continue;
+                sum += scores[min<size_t>(breaks[var], scores.size() - 1)];
+                candidates.emplace_back(var, sum);
+            }
+            if (candidates.empty()) return false;  // falsified at level 0
+            double pick = unit(rng) * sum;
+            size_t i = 0;
+            while (i + 1 < candidates.size() && candidates[i].second <= pick) ++i;
+            flip(candidates[i].first);
+            if (unsat.size() < best_unsat) {
+                best_unsat = unsat.size();
+                best = values;
             }
         }
+        return unsat.empty();
     }
-    return {"unresolved", nullopt};
-}
 
-pair<int, Clause> conflict_analysis(const Clause& clause, const Assignments& assignments) {
-    if (assignments.dl == 0) return {-1, clause};
+private:
+    const Formula& formula;
+    vector<ClauseRef> clauses;      // the clauses not satisfied at level 0
+    vector<uint32_t> starts;
+    vector<uint32_t> occurrences;   // clause indices
+    vector<uint32_t> true_count;    // per clause
+    vector<uint32_t> critical;      // per clause: xor of its true variables, the only one if true_count is 1
+    vector<uint32_t> breaks;        // per variable
+    vector<uint32_t> unsat;         // falsified clauses
+    vector<uint32_t> position;      // of each clause in unsat, or UINT32_MAX
+    size_t best_unsat;
+    array<double, 64> scores;
 
-    Clause learned_clause = clause;
-    int decision_level = assignments.dl - 1;
+    bool satisfied(const Literal& lit) const {
+        return values[lit.variable()] == (lit.negation() ? 0 : 1);
+    }
 
-    return {decision_level, learned_clause};
-}
+    void falsify(uint32_t c) {
+        position[c] = static_cast<uint32_t>(unsat.size());
+        unsat.push_back(c);
+    }
 
-optional<Assignments> cdcl_solve(Formula& formula) {
-    Assignments assignments;
+    void satisfy(uint32_t c) {
+        uint32_t last = unsat.back();
+        unsat[position[c]] = last;
+        position[last] = position[c];
+        unsat.pop_back();
+        position[c] = UINT32_MAX;
+    }
 
-    auto [reason, clause] = unit_propagation(formula, assignments);
-    if (reason == "conflict") return nullopt;
+    void flip(int var) {
+        ++flips;
+        values[var] ^= 1;
+        uint32_t v = static_cast<uint32_t>(var);
+        Literal now_true(var, values[var] == 0);
+        for (uint32_t i = starts[now_true.index()]; i < starts[now_true.index() + 1]; ++i) {
+            uint32_t c = occurrences[i];
+            if (true_count[c] == 0) {
+                satisfy(c);
+                ++breaks[v];
+            } else if (true_count[c] == 1) {
+                --breaks[critical[c]];
+            }
+            ++true_count[c];
+            critical[c] ^= v;
+        }
+        Literal now_false = now_true.neg();
+        for (uint32_t i = starts[now_false.index()]; i < starts[now_false.index() + 1]; ++i) {
+            uint32_t c = occurrences[i];
+            --true_count[c];
+            critical[c] ^= v;
+            if (true_count[c] == 0) {
+                falsify(c);
+                --breaks[v];
+            } else if (true_count[c] == 1) {
+                ++breaks[critical[c]];
+            }
+        }
+        ticks += starts[now_true.index() + 1] - starts[now_true.index()] + starts[now_false.index() + 1] -
+                 starts[now_false.index()];
+    }
+};
 
-    while (!all_variables_assigned(formula, assignments)) {
-        auto [var, val] = pick_branching_variable(formula, assignments);
-        assignments.dl++;
-        assignments.assign(var, val, nullopt);
+// EVSIDS activities with an indexed binary max-heap of the decision candidates.
+// Assigned variables are removed lazily when they surface at the top.
+class VarOrder {
+public:
+    vector<double> activity;
+    vector<int> heap;
+    vector<int> position;  // index of each variable in heap, -1 when absent
+    double increment;
+    double decay;
 
-        while (true) {
-            tie(reason, clause) = unit_propagation(formula, assignments);
-            if (reason != "conflict") break;
+    VarOrder(int max_variable, double var_decay)
+        : activity(max_variable + 1, 0.0), position(max_variable + 1, -1), increment(1.0), decay(var_decay) {}
 
-            auto [b, learned_clause] = conflict_analysis(clause.value(), assignments);
-            if (b < 0) return nullopt;
+    void resize(int max_variable) {
+        size_t size = static_cast<size_t>(max_variable) + 1;
+        if (size <= activity.size()) return;
+        activity.resize(size, 0.0);
+        position.resize(size, -1);
+    }
 
-            formula.clauses.push_back(learned_clause);
-            backtrack(assignments, b);
-            assignments.dl = b;
-        }
+    // Empties the heap and zeroes the activities; the tables keep their size.
+    void clear() {
+        fill(activity.begin(), activity.end(), 0.0);
+        heap.clear();
+        fill(position.begin(), position.end(), -1);
+        increment = 1.0;
     }
 
-    return assignments;
-}
+    bool contains(int var) const {
+        return position[var] >= 0;
+    }
 
-Formula parse_dimacs_cnf(const string& content) {
-    vector<Clause> clauses;
-    vector<Literal> current_clause;
+    bool empty() const {
+        return heap.empty();
+    }
 
-    istringstream iss(content);
-    string line;
-    while (getline(iss, line)) {
-        istringstream tokens(line);
-        string token;
-        while (tokens >> token) {
-            if (token == "c" || token == "p") break;
-
-            int lit = stoi(token);
-            if (lit == 0) {
-                clauses.emplace_back(current_clause);
-                current_clause.clear();
-            } else {
-                int var = abs(lit);
-                bool neg = lit < 0;
-                current_clause.push_back(Literal(var, neg));
-            }
+    void insert(int var) {
+        if (contains(var)) return;
+        position[var] = static_cast<int>(heap.size());
+        heap.push_back(var);
+        sift_up(position[var]);
+    }
+
+    void remove(int var) {
+        if (!contains(var)) return;
+        int i = position[var];
+        int last = heap.back();
+        heap.pop_back();
+        position[var] = -1;
+        if (last == var) return;
+        heap[i] = last;
+        position[last] = i;
+        sift_up(i);
+        sift_down(position[last]);
+    }
+
+    int pop_max() {
+        int top = heap[0];
+        heap[0] = heap.back();
+        position[heap[0]] = 0;
+        heap.pop_back();
+        position[top] = -1;
+        if (!heap.empty()) sift_down(0);
+        return top;
+    }
+
+    void bump(int var) {
+        activity[var] += increment;
+        if (activity[var] > 1e100) rescale();
+        if (contains(var)) sift_up(position[var]);
+    }
+
+    void decay_activities() {
+        increment /= decay;
+    }
+
+private:
+    bool before(int a, int b) const {
+        return activity[a] > activity[b];
+    }
+
+    void sift_up(int i) {
+        int var = heap[i];
+        while (i > 0) {
+            int parent = (i - 1) / 2;
+            if (!before(var, heap[parent])) break;
+            heap[i] = heap[parent];
+            position[heap[i]] = i;
+            i = parent;
+        }
+        heap[i] = var;
+        position[var] = i;
+    }
+
+    void sift_down(int i) {
+        int var = heap[i];
+        int n = static_cast<int>(heap.size());
+        while (2 * i + 1 < n) {
+            int child = 2 * i + 1;
+            if (child + 1 < n && before(heap[child + 1], heap[child])) ++child;
+            if (!before(heap[child], var)) break;
+            heap[i] = heap[child];
+            position[heap[i]] = i;
+            i = child;
         }
+        heap[i] = var;
+        position[var] = i;
     }
 
-    return Formula(clauses);
+    // Scaling every activity by the same factor keeps the heap order intact.
+    void rescale() {
+        for (double& act : activity) act *= 1e-100;
+        increment *= 1e-100;
+    }
+};
+
+// Decides when cdcl_solve abandons the current trail and returns to level 0.
+// Learned clauses, activities and saved phases survive the restart.
+class RestartPolicy {
+public:
+    virtual ~RestartPolicy() = default;
+
+    virtual void on_conflict(unsigned lbd, size_t trail_size) = 0;
+    virtual bool should_restart() const = 0;
+    virtual void on_restart() = 0;
+};
+
+class NoRestarts : public RestartPolicy {
+public:
+    void on_conflict(unsigned, size_t) override {}
+    bool should_restart() const override { return false; }
+    void on_restart() override {}
+};
+
+// MiniSat's formulation: the x-th element of the Luby sequence with base y.
+double luby(double y, uint64_t x) {
+    uint64_t size = 1;
+    int seq = 0;
+    while (size < x + 1) {
+        ++seq;
+        size = 2 * size + 1;
+    }
+    while (size - 1 != x) {
+        size = (size - 1) >> 1;
+        --seq;
+        x = x % size;
+    }
+    return pow(y, seq);
 }
 
-int main(int argc, char* argv[]) {
-    if (argc != 2) {
-        cout << "Please provide a DIMACS CNF filename as an argument." << endl;
-        return 1;
+// Restarts after a conflict budget that is recomputed from the restart count.
+class ScheduledRestarts : public RestartPolicy {
+public:
+    ScheduledRestarts(const SolverOptions& options)
+        : mode(options.restart_mode), base(options.restart_base), factor(options.restart_factor),
+          restarts(0), conflicts(0) {
+        limit = interval();
     }
 
-    ifstream file(argv[1]);
-    if (!file.is_open()) {
-        cout << "Unable to open the file: " << argv[1] << endl;
-        return 1;
+    void on_conflict(unsigned, size_t) override { ++conflicts; }
+    bool should_restart() const override { return conflicts >= limit; }
+
+    void on_restart() override {
+        ++restarts;
+        conflicts = 0;
+        limit = interval();
+    }
+
+private:
+    RestartMode mode;
+    uint64_t base;
+    double factor;
+    uint64_t restarts;
+    uint64_t conflicts;
+    double limit;
+
+    double interval() const {
+        if (mode == RestartMode::LUBY) return base * luby(2, restarts);
+        return base * pow(factor, static_cast<double>(restarts));
+    }
+};
+
+// Exponential moving average with bias correction, so early values are not dragged
+// towards the zero initialisation.
+struct Ema {
+    double alpha;
+    double biased;
+    double decay_power;
+
+    Ema(double a) : alpha(a), biased(0), decay_power(1) {}
+
+    void update(double x) {
+        biased += alpha * (x - biased);
+        decay_power *= 1 - alpha;
     }
 
-    stringstream buffer;
-    buffer << file.rdbuf();
-    string dimacs_cnf = buffer.str();
+    double value() const {
+        return decay_power < 1 ? biased / (1 - decay_power) : 0;
+    }
+};
 
-    Formula formula = parse_dimacs_cnf(dimacs_cnf);
-    optional<Assignments> result = cdcl_solve(formula);
+// Glucose-style dynamic restarts on EMAs of learned clause LBD: restart when the fast
+// average exceeds the slow one by the margin, and block restarts while the trail is
+// much longer than usual, since the solver is then likely approaching a model.
+class GlucoseRestarts final : public RestartPolicy {
+public:
+    GlucoseRestarts() : fast(1.0 / 32), slow(1.0 / 4096), trail(1.0 / 4096), conflicts(0), since_restart(0) {}
 
-    if (result.has_value()) {
-        assert(result->satisfy(formula));
-        cout << "Formula is SAT with assignments:" << endl;
-        for (const auto& [var, assignment] : result->assignments) {
-            cout << var << ": " << (assignment.value ? "True" : "False") << endl;
+    void on_conflict(unsigned lbd, size_t trail_size) override {
+        ++conflicts;
+        ++since_restart;
+        fast.update(lbd);
+        slow.update(lbd);
+        if (conflicts > BLOCK_AFTER && since_restart >= MIN_CONFLICTS &&
+            trail_size > BLOCK_MARGIN * trail.value()) {
+            since_restart = 0;
         }
-    } else {
-        cout << "Formula is UNSAT." << endl;
-        cout << "No satisfying assignment exists for the given formula." << endl;  // Additional output for UNSAT
+        trail.update(static_cast<double>(trail_size));
     }
 
-    return 0;
+    bool should_restart() const override {
+        return since_restart >= MIN_CONFLICTS && fast.value() * RESTART_MARGIN > slow.value();
+    }
+
+    void on_restart() override { since_restart = 0; }
+
+private:
+    static constexpr uint64_t MIN_CONFLICTS = 50;
+    static constexpr uint64_t BLOCK_AFTER = 10000;
+    static constexpr double RESTART_MARGIN = 0.8;
+    static constexpr double BLOCK_MARGIN = 1.4;
+
+    Ema fast;
+    Ema slow;
+    Ema trail;
+    uint64_t conflicts;
+    uint64_t since_restart;
+};
+
+unique_ptr<RestartPolicy> make_restart_policy(const SolverOptions& options) {
+    switch (options.restart_mode) {
+        case RestartMode::LUBY:
+        case RestartMode::GEOMETRIC:
+            return make_unique<ScheduledRestarts>(options);
+        case RestartMode::GLUCOSE:
+            return make_unique<GlucoseRestarts>();
+        case RestartMode::NONE:
+        default:
+            return make_unique<NoRestarts>();
+    }
+}
+
+pair<int, bool> pick_branching_variable(VarOrder& order, const Assignments& assignments, const Phases& phases,
+                                        const SolverOptions& options, mt19937& rng) {
+    int var = 0;
+    if (options.random_branch_freq > 0 && !order.empty()) {
+        uniform_real_distribution<> coin(0.0, 1.0);
+        if (coin(rng) < options.random_branch_freq) {
+            uniform_int_distribution<size_t> pick(0, order.heap.size() - 1);
+            int candidate = order.heap[pick(rng)];
+            if (!assignments.is_assigned(candidate)) var = candidate;
+        }
+    }
+    while (var == 0 || assignments.is_assigned(var)) {
+        if (order.empty()) return {0, false};  // every candidate is assigned
+        var = order.pop_max();
+    }
+    return {var, phases.polarity(var, assignments, options)};
+}
+
+void backtrack(Assignments& assignments, int b, VarOrder& order) {
+    if (assignments.decision_level() <= b) return;
+
+    // Everything above level b lies in the trail suffix starting at its level marker. The suffix
+    // can also hold out-of-order assignments of level b or below: they stay, in trail order, and
+    // are propagated again, since clauses they falsified may have lost their true literal.
+    size_t start = assignments.trail_lim[b];
+    size_t kept = start;
+    for (size_t i = start; i < assignments.trail.size(); ++i) {
+        const Literal& lit = assignments.trail[i];
+        int var = lit.variable();
+        if (assignments.level(var) <= b) {
+            assignments.trail[kept++] = lit;
+            continue;
+        }
+        assignments.saved_phases[var] = lit.negation() ? 0 : 1;
+        assignments.unassign(var);
+        order.insert(var);
+    }
+    assignments.trail.resize(kept);
+    assignments.trail_lim.erase(assignments.trail_lim.begin() + b, assignments.trail_lim.end());
+    assignments.qhead = min(assignments.qhead, start);
+}
+
+// A clause is watched by its first two literals; the blocker is some other literal
+// of the clause whose truth lets us skip the clause without touching its memory.
+struct Watcher {
+    ClauseRef clause;
+    Literal blocker;
+
+    Watcher(ClauseRef cls, Literal blk) : clause(cls), blocker(blk) {}
+};
+
+struct Watches {
+    // lists[lit.index()] holds the clauses currently watching lit, visited when lit becomes false.
+    vector<vector<Watcher>> lists;
+    // Binary clauses are watched apart, with the other literal as blocker, so propagating them
+    // never reads clause memory; the reference is kept only to report reasons and conflicts.
+    vector<vector<Watcher>> binaries;
+    uint64_t ticks = 0;  // watchers visited by propagation, the unit of inprocessing effort
+    uint64_t propagations = 0;  // literals propagated
+
+    Watches(int max_variable)
+        : lists(2 * static_cast<size_t>(max_variable) + 2), binaries(2 * static_cast<size_t>(max_variable) + 2) {}
+
+    void resize(int max_variable) {
+        size_t size = 2 * static_cast<size_t>(max_variable) + 2;
+        if (size <= lists.size()) return;
+        lists.resize(size);
+        binaries.resize(size);
+    }
+
+    // Empties every watch list, keeping each list's allocation.
+    void clear() {
+        for (vector<Watcher>& ws : lists) ws.clear();
+        for (vector<Watcher>& ws : binaries) ws.clear();
+        ticks = 0;
+        propagations = 0;
+    }
+
+    void attach(const Formula& formula, ClauseRef ref) {
+        const Clause& clause = formula.clause(ref);
+        vector<vector<Watcher>>& target = clause.size() == 2 ? binaries : lists;
+        target[clause[0].index()].emplace_back(ref, clause[1]);
+        target[clause[1].index()].emplace_back(ref, clause[0]);
+    }
+
+    // Undoes attach() for a clause of more than two literals; linear in the two watch lists.
+    void detach(const Formula& formula, ClauseRef ref) {
+        const Clause& clause = formula.clause(ref);
+        for (const Literal& lit : {clause[0], clause[1]}) {
+            vector<Watcher>& ws = lists[lit.index()];
+            ws.erase(find_if(ws.begin(), ws.end(), [&](const Watcher& w) { return w.clause == ref; }));
+        }
+    }
+};
+
+// Level an implication through clause gets: the highest level among its false literals,
+// all but lits[0]. from is the level of the literal being propagated, a lower bound.
+int implication_level(const Clause& lits, const Assignments& assignments, int from) {
+    int level = from;
+    for (size_t k = 2; k < lits.size(); ++k) level = max(level, assignments.level(lits[k].variable()));
+    return level;
+}
+
+// Moves the two best watch candidates of a clause to the front: non-false literals first,
+// then false literals assigned at the highest decision level.
+void order_watches(vector<Literal>& clause, const Assignments& assignments) {
+    auto rank = [&](const Literal& lit) {
+        if (!assignments.falsified(lit)) return INT32_MAX;
+        return assignments.level(lit.variable());
+    };
+    vector<Literal>& lits = clause;
+    for (size_t w = 0; w < 2 && w < lits.size(); ++w) {
+        size_t best = w;
+        for (size_t i = w + 1; i < lits.size(); ++i) {
+            if (rank(lits[i]) > rank(lits[best])) best = i;
+        }
+        swap(lits[w], lits[best]);
+    }
+}
+
+pair<string, optional<ClauseRef>> unit_propagation(Formula& formula, Assignments& assignments, Watches& watches) {
+    while (assignments.qhead < assignments.trail.size()) {
+        Literal false_lit = assignments.trail[assignments.qhead++].neg();
+        // Implied literals get this level, unless false_lit was assigned out of order and the
+        // clause holds false literals of higher levels.
+        int level = assignments.level(false_lit.variable());
+        bool out_of_order = level < assignments.decision_level();
+        ++watches.propagations;
+        watches.ticks += watches.binaries[false_lit.index()].size() + watches.lists[false_lit.index()].size();
+
+        for (const Watcher& w : watches.binaries[false_lit.index()]) {
+            if (assignments.value(w.blocker)) continue;
+            if (assignments.falsified(w.blocker)) {
+                assignments.qhead = assignments.trail.size();
+                return {"conflict", w.clause};
+            }
+            assignments.assign(w.blocker.variable(), !w.blocker.negation(), w.clause, level);
+        }
+
+        vector<Watcher>& ws = watches.lists[false_lit.index()];
+
+        size_t i = 0, j = 0;
+        while (i < ws.size()) {
+            Watcher w = ws[i++];
+            if (assignments.value(w.blocker)) {
+                ws[j++] = w;
+                continue;
+            }
+
+            Clause& lits = formula.clause(w.clause);
+            if (lits[0] == false_lit) swap(lits[0], lits[1]);
+            Literal first = lits[0];
+            if (first != w.blocker && assignments.value(first)) {
+                ws[j++] = Watcher(w.clause, first);
+                continue;
+            }
+
+            bool found_watch = false;
+            for (size_t k = 2; k < lits.size(); ++k) {
+                if (!assignments.falsified(lits[k])) {
+                    swap(lits[1], lits[k]);
+                    watches.lists[lits[1].index()].emplace_back(w.clause, first);
+                    found_watch = true;
+                    break;
+                }
+            }
+            if (found_watch) continue;
+
+            ws[j++] = Watcher(w.clause, first);
+            if (assignments.falsified(first)) {
+                while (i < ws.size()) ws[j++] = ws[i++];
+                ws.erase(ws.begin() + j, ws.end());
+                assignments.qhead = assignments.trail.size();
+                return {"conflict", w.clause};
+            }
+            assignments.assign(first.variable(), !first.negation(), w.clause,
+                               out_of_order ? implication_level(lits, assignments, level) : level);
+        }
+        ws.erase(ws.begin() + j, ws.end());
+    }
+    return {"unresolved", nullopt};
+}
+
+// Clausal proof of unsatisfiability, written through one large buffer. DRAT lists added and
+// deleted clauses for the checker to re-derive by unit propagation. LRAT numbers every clause,
+// the originals 1..m in input order, and follows each added clause with its hints: the clauses
+// that turn unit, and finally conflicting, under the negation of the new clause. Hints come from
+// the implication graph, so only derivations made by propagation can be logged in LRAT.
+class Proof {
+public:
+    static constexpr size_t BUFFER_SIZE = 1 << 20;
+
+    Proof(int fd, ProofFormat format) : fd(fd), format(format), buffer(BUFFER_SIZE), used(0), next_id(1), units_cursor(0) {}
+
+    ~Proof() {
+        if (fd < 0) return;
+        try {
+            flush();
+        } catch (const runtime_error&) {
+        }
+        ::close(fd);
+    }
+
+    Proof(const Proof&) = delete;
+    Proof& operator=(const Proof&) = delete;
+
+    bool lrat() const {
+        return format == ProofFormat::LRAT;
+    }
+
+    // Numbers the next original clause, in input order.
+    void original(ClauseRef ref) {
+        if (lrat()) ids[ref] = next_id++;
+    }
+
+    // Logs a clause implied by the current clauses, stored at ref unless NO_REASON. In LRAT its
+    // hints are those prepared by chain().
+    template <typename Lits>
+    void add(const Lits& lits, ClauseRef ref = NO_REASON) {
+        if (lrat()) {
+            uint64_t id = write_lrat(lits, hints);
+            if (ref != NO_REASON) ids[ref] = id;
+            hints.clear();
+            return;
+        }
+        write_drat('a', lits);
+    }
+
+    // Logs the deletion of a clause; LRAT identifies it by ref.
+    template <typename Lits>
+    void remove(const Lits& lits, ClauseRef ref = NO_REASON) {
+        if (!lrat()) {
+            write_drat('d', lits);
+            return;
+        }
+        auto entry = ids.find(ref);
+        if (entry == ids.end()) return;
+        reserve();
+        put_number(next_id - 1);
+        put(" d ");
+        put_number(entry->second);
+        put(" 0\n");
+        ids.erase(entry);
+    }
+
+    // Logs every level-0 assignment as a unit clause, so that the reasons behind them can be
+    // deleted. Call at level 0.
+    void log_units(const Formula& formula, const Assignments& assignments) {
+        if (lrat()) {
+            for (const Literal& lit : assignments.trail) unit(lit.variable(), formula, assignments);
+            return;
+        }
+        for (; units_cursor < assignments.trail.size(); ++units_cursor) {
+            const Literal* lit = &assignments.trail[units_cursor];
+            write_drat('a', lit, lit + 1);
+        }
+    }
+
+    // LRAT hints of the clause learned from conflict, taken before backjumping: the level-0
+    // units involved, then the reasons of every implied literal between the conflict and the
+    // learned clause in trail order, then the conflict itself.
+    void chain(const Formula& formula, const Assignments& assignments, ClauseRef conflict, const vector<Literal>& learned) {
+        if (!lrat()) return;
+        hints.clear();
+        resolved.clear();
+        if (marks.size() < assignments.values.size()) marks.resize(assignments.values.size(), 0);
+        for (const Literal& lit : learned) marks[lit.variable()] = 2;
+        size_t pending = 0;
+        auto visit = [&](ClauseRef ref, int skip) {
+            for (const Literal& q : formula.clause(ref)) {
+                int var = q.variable();
+                if (var == skip || marks[var]) continue;
+                marks[var] = 1;
+                touched.push_back(var);
+                if (assignments.level(var) == 0) {
+                    hints.push_back(unit(var, formula, assignments));
+                } else {
+                    ++pending;
+                }
+            }
+        };
+        visit(conflict, 0);
+        for (size_t i = assignments.trail.size(); pending > 0;) {
+            int var = assignments.trail[--i].variable();
+            if (marks[var] != 1 || assignments.level(var) == 0) continue;
+            --pending;
+            ClauseRef reason = assignments.reason(var);
+            assert(reason != NO_REASON);
+            resolved.push_back(reason);
+            visit(reason, var);
+        }
+        for (size_t i = resolved.size(); i-- > 0;) hints.push_back(ids.at(resolved[i]));
+        hints.push_back(ids.at(conflict));
+        for (const Literal& lit : learned) marks[lit.variable()] = 0;
+        for (int var : touched) marks[var] = 0;
+        touched.clear();
+    }
+
+    // Logs the empty clause after conflict, a clause falsified at level 0 (NO_REASON if unknown).
+    void conclude(const Formula& formula, const Assignments& assignments, ClauseRef conflict) {
+        hints.clear();
+        if (lrat() && conflict != NO_REASON) {
+            for (const Literal& lit : formula.clause(conflict)) {
+                uint64_t id = unit(lit.variable(), formula, assignments);
+                if (find(hints.begin(), hints.end(), id) == hints.end()) hints.push_back(id);
+            }
+            hints.push_back(ids.at(conflict));
+        }
+        add(vector<Literal>());
+    }
+
+    // Follows the clauses to the references a planned compaction of arena gives them.
+    void relocate(const ClauseArena& arena) {
+        if (!lrat()) return;
+        unordered_map<ClauseRef, uint64_t> moved;
+        moved.reserve(ids.size());
+        for (const auto& [ref, id] : ids) {
+            ClauseRef to = arena.forward(ref);
+            if (to != NO_REASON) moved.emplace(to, id);
+        }
+        ids.swap(moved);
+    }
+
+    void flush() {
+        for (size_t done = 0; done < used;) {
+            ssize_t wrote = ::write(fd, buffer.data() + done, used - done);
+            if (wrote < 0 && errno == EINTR) continue;
+            if (wrote < 0) throw runtime_error(string("proof write failed: ") + strerror(errno));
+            done += static_cast<size_t>(wrote);
+        }
+        used = 0;
+    }
+
+private:
+    static constexpr size_t RECORD_ROOM = 32;  // bytes reserved before writing one number
+
+    int fd;
+    ProofFormat format;
+    vector<char> buffer;
+    size_t used;
+    uint64_t next_id;
+    unordered_map<ClauseRef, uint64_t> ids;  // LRAT number of every live clause in the arena
+    vector<uint64_t> unit_ids;               // variable -> LRAT number of its level-0 unit clause
+    size_t units_cursor;                     // level-0 trail entries already logged as units
+    vector<uint64_t> hints;
+    vector<uint64_t> unit_hints;
+    vector<ClauseRef> resolved;
+    vector<uint8_t> marks;                   // per-variable: 1 in the implication cone, 2 in the learned clause
+    vector<int> touched;
+
+    void reserve() {
+        if (used + RECORD_ROOM > buffer.size()) flush();
+    }
+
+    void put(const char* text) {
+        while (*text) buffer[used++] = *text++;
+    }
+
+    void put_number(uint64_t value) {
+        char digits[20];
+        size_t count = 0;
+        do {
+            digits[count++] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value);
+        while (count) buffer[used++] = digits[--count];
+    }
+
+    void put_literal(const Literal& lit) {
+        if (lit.negation()) buffer[used++] = '-';
+        put_number(static_cast<uint64_t>(lit.variable()));
+    }
+
+    template <typename Lits>
+    void write_drat(char kind, const Lits& lits) {
+        write_drat(kind, lits.begin(), lits.end());
+    }
+
+    // Binary DRAT: 'a' or 'd', then each literal as 2 * variable + sign in 7-bit groups,
+    // least significant first, then a zero byte.
+    template <typename Iterator>
+    void write_drat(char kind, Iterator begin, Iterator end) {
+        if (format == ProofFormat::DRAT_BINARY) {
+            reserve();
+            buffer[used++] = kind;
+            for (Iterator lit = begin; lit != end; ++lit) {
+                reserve();
+                uint32_t code = lit->code;
+                while (code > 127) {
+                    buffer[used++] = static_cast<char>((code & 127) | 128);
+                    code >>= 7;
+                }
+                buffer[used++] = static_cast<char>(code);
+            }
+            buffer[used++] = 0;
+            return;
+        }
+        reserve();
+        if (kind == 'd') put("d ");
+        for (Iterator lit = begin; lit != end; ++lit) {
+            reserve();
+            put_literal(*lit);
+            buffer[used++] = ' ';
+        }
+        put("0\n");
+    }
+
+    template <typename Lits>
+    uint64_t write_lrat(const Lits& lits, const vector<uint64_t>& antecedents) {
+        uint64_t id = next_id++;
+        reserve();
+        put_number(id);
+        for (const Literal& lit : lits) {
+            reserve();
+            buffer[used++] = ' ';
+            put_literal(lit);
+        }
+        put(" 0");
+        for (uint64_t hint : antecedents) {
+            reserve();
+            buffer[used++] = ' ';
+            put_number(hint);
+        }
+        put(" 0\n");
+        return id;
+    }
+
+    // LRAT number of the unit clause of var, fixed at level 0. Units are derived in trail order,
+    // each from its reason and the units of the reason's other literals.
+    uint64_t unit(int var, const Formula& formula, const Assignments& assignments) {
+        if (unit_ids.size() < assignments.values.size()) unit_ids.resize(assignments.values.size(), 0);
+        while (!unit_ids[var]) {
+            const Literal lit = assignments.trail[units_cursor++];
+            ClauseRef reason = assignments.reason(lit.variable());
+            assert(reason != NO_REASON);
+            const Clause& clause = formula.clause(reason);
+            if (clause.size() == 1) {
+                unit_ids[lit.variable()] = ids.at(reason);
+                continue;
+            }
+            unit_hints.clear();
+            for (const Literal& q : clause) {
+                uint64_t id = unit_ids[q.variable()];
+                if (q.variable() != lit.variable() && find(unit_hints.begin(), unit_hints.end(), id) == unit_hints.end()) {
+                    unit_hints.push_back(id);
+                }
+            }
+            unit_hints.push_back(ids.at(reason));
+            unit_ids[lit.variable()] = write_lrat(array<Literal, 1>{lit}, unit_hints);
+        }
+        return unit_ids[var];
+    }
+};
+
+// Failed-literal probing at level 0 over the binary implication graph alone. Each root
+// literal (one with implications but implied by no binary clause) is expanded by a search
+// that only reads the binary watch lists; if it reaches both x and ~x, or a literal already
+// false, the root cannot be true and its negation is fixed. Returns false on a conflict.
+// Probing resumes at cursor, where an earlier call ran out of budget. Units go to proof if set.
+bool probe_failed_literals(Formula& formula, Assignments& assignments, Watches& watches, uint64_t budget,
+                           uint32_t& cursor, Proof* proof) {
+    uint32_t literal_count = static_cast<uint32_t>(watches.binaries.size());
+    vector<uint32_t> stamps(literal_count, 0);
+    vector<Literal> stack;
+    uint32_t stamp = 0;
+    uint64_t ticks = 0;
+
+    for (uint32_t step = 2; step < literal_count && ticks < budget; ++step) {
+        if (cursor < 2 || cursor >= literal_count) cursor = 2;
+        Literal root;
+        root.code = cursor++;
+        // Setting root true visits the binaries of ~root; nothing implies root if its own list is empty.
+        if (assignments.is_assigned(root.variable()) || watches.binaries[root.neg().index()].empty() ||
+            !watches.binaries[root.index()].empty()) {
+            continue;
+        }
+
+        ++stamp;
+        stamps[root.index()] = stamp;
+        stack.assign(1, root);
+        bool failed = false;
+        while (!stack.empty() && !failed) {
+            Literal lit = stack.back();
+            stack.pop_back();
+            for (const Watcher& w : watches.binaries[lit.neg().index()]) {
+                ++ticks;
+                Literal implied = w.blocker;
+                if (stamps[implied.index()] == stamp || assignments.value(implied)) continue;
+                if (assignments.falsified(implied) || stamps[implied.neg().index()] == stamp) {
+                    failed = true;
+                    break;
+                }
+                stamps[implied.index()] = stamp;
+                stack.push_back(implied);
+            }
+        }
+        if (!failed) continue;
+
+        Literal unit = root.neg();
+        if (proof) proof->add(array<Literal, 1>{unit});
+        assignments.assign(unit.variable(), !unit.negation(), NO_REASON);
+        if (unit_propagation(formula, assignments, watches).first == "conflict") return false;
+    }
+    return true;
+}
+
+// Literal block distance: the number of distinct decision levels in the clause. Levels are
+// counted by stamping them in a table kept from one call to the next.
+class LbdCounter {
+public:
+    template <typename Lits>
+    unsigned operator()(const Lits& lits, const Assignments& assignments) {
+        if (stamps.size() <= static_cast<size_t>(assignments.decision_level())) {
+            stamps.resize(assignments.decision_level() + 1, 0);
+        }
+        if (++stamp == 0) {
+            fill(stamps.begin(), stamps.end(), 0);
+            stamp = 1;
+        }
+        unsigned lbd = 0;
+        for (const Literal& lit : lits) {
+            uint32_t& level = stamps[assignments.level(lit.variable())];
+            if (level != stamp) {
+                level = stamp;
+                ++lbd;
+            }
+        }
+        return lbd;
+    }
+
+private:
+    vector<uint32_t> stamps;  // per decision level: the call that last counted it
+    uint32_t stamp = 0;
+};
+
+// Learned clauses, kept apart from the originals in three tiers by LBD: core clauses are
+// kept forever, tier2 clauses while they keep taking part in conflicts, and the local tier
+// is halved at every reduction.
+class ClauseDatabase {
+public:
+    vector<ClauseRef> core;
+    vector<ClauseRef> tier2;
+    vector<ClauseRef> local;
+    float increment;
+    uint64_t next_reduce;
+    uint64_t reductions;
+    Proof* proof = nullptr;  // receives the deletions of reduce
+    uint64_t deleted = 0;    // clauses dropped by reduce
+    LbdCounter compute_lbd;
+
+    ClauseDatabase(const SolverOptions& options)
+        : increment(1), next_reduce(options.reduce_interval), reductions(0), options(options) {}
+
+    // Forgets every learned clause; their memory belongs to the formula's arena.
+    void clear() {
+        core.clear();
+        tier2.clear();
+        local.clear();
+        increment = 1;
+        next_reduce = options.reduce_interval;
+        reductions = 0;
+        deleted = 0;
+    }
+
+    size_t size() const {
+        return core.size() + tier2.size() + local.size();
+    }
+
+    ClauseRef learn(Formula& formula, const vector<Literal>& lits, unsigned lbd) {
+        ClauseRef ref = formula.arena.alloc(lits, true);
+        formula.clause(ref).lbd = lbd;
+        // Binary clauses are never reduced: locked() assumes the implied literal comes first,
+        // which binary propagation does not maintain.
+        (lits.size() == 2 ? core : tier_for(lbd)).push_back(ref);
+        return ref;
+    }
+
+    // Called for learned clauses resolved on during conflict analysis.
+    void on_used(Formula& formula, ClauseRef ref, const Assignments& assignments) {
+        Clause& clause = formula.clause(ref);
+        bump(formula, clause);
+        clause.used = clause.lbd <= options.tier2_lbd ? 2 : 1;
+        if (clause.lbd > options.core_lbd) {
+            unsigned lbd = compute_lbd(clause, assignments);
+            if (lbd < clause.lbd) clause.lbd = lbd;
+        }
+    }
+
+    void decay_activities() {
+        increment /= static_cast<float>(options.clause_decay);
+    }
+
+    // Drops clauses freed outside reduce from the tiers; clauses shrunk to binaries move to core.
+    void purge(const Formula& formula) {
+        for (vector<ClauseRef>* tier : {&tier2, &local}) {
+            size_t kept = 0;
+            for (ClauseRef ref : *tier) {
+                const Clause& clause = formula.clause(ref);
+                if (clause.removed) continue;
+                if (clause.size() <= 2) {
+                    core.push_back(ref);
+                } else {
+                    (*tier)[kept++] = ref;
+                }
+            }
+            tier->resize(kept);
+        }
+        core.erase(remove_if(core.begin(), core.end(), [&](ClauseRef ref) { return formula.clause(ref).removed; }),
+                   core.end());
+    }
+
+    bool should_reduce(uint64_t conflicts) const {
+        return conflicts >= next_reduce;
+    }
+
+    void reduce(Formula& formula, Assignments& assignments, Watches& watches, uint64_t conflicts) {
+        ++reductions;
+        next_reduce = conflicts + options.reduce_interval + reductions * options.reduce_increment;
+
+        // Re-tier by the current LBD, demoting tier2 clauses that went unused since the last reduction.
+        vector<ClauseRef> candidates;
+        vector<ClauseRef> kept_tier2;
+        for (ClauseRef ref : tier2) {
+            Clause& clause = formula.clause(ref);
+            if (clause.lbd <= options.core_lbd) {
+                core.push_back(ref);
+            } else if (clause.used) {
+                --clause.used;
+                kept_tier2.push_back(ref);
+            } else {
+                candidates.push_back(ref);
+            }
+        }
+        for (ClauseRef ref : local) {
+            Clause& clause = formula.clause(ref);
+            if (clause.lbd <= options.core_lbd) {
+                core.push_back(ref);
+            } else if (clause.lbd <= options.tier2_lbd) {
+                kept_tier2.push_back(ref);
+            } else {
+                candidates.push_back(ref);
+            }
+        }
+        tier2.swap(kept_tier2);
+
+        // Delete the least useful half of the local tier: high LBD first, then low activity.
+        sort(candidates.begin(), candidates.end(), [&](ClauseRef a, ClauseRef b) {
+            const Clause& x = formula.clause(a);
+            const Clause& y = formula.clause(b);
+            if (x.lbd != y.lbd) return x.lbd > y.lbd;
+            return x.activity < y.activity;
+        });
+        local.clear();
+        size_t target = candidates.size() / 2;
+        for (size_t i = 0; i < candidates.size(); ++i) {
+            ClauseRef ref = candidates[i];
+            Clause& clause = formula.clause(ref);
+            if (i < target && !clause.used && !locked(formula, ref, assignments)) {
+                if (proof) proof->remove(clause, ref);
+                formula.arena.free(ref);
+                ++deleted;
+            } else {
+                clause.used = 0;
+                local.push_back(ref);
+            }
+        }
+
+        detach_removed(formula, watches);
+        if (formula.arena.wasted > formula.arena.size() / 5) collect_garbage(formula, assignments, watches);
+    }
+
+private:
+    SolverOptions options;
+
+    vector<ClauseRef>& tier_for(unsigned lbd) {
+        if (lbd <= options.core_lbd) return core;
+        if (lbd <= options.tier2_lbd) return tier2;
+        return local;
+    }
+
+    void bump(Formula& formula, Clause& clause) {
+        clause.activity += increment;
+        if (clause.activity > 1e20f) {
+            for (vector<ClauseRef>* tier : {&core, &tier2, &local}) {
+                for (ClauseRef ref : *tier) formula.clause(ref).activity *= 1e-20f;
+            }
+            increment *= 1e-20f;
+        }
+    }
+
+    // A clause is the reason of its first literal while that literal stays assigned.
+    static bool locked(const Formula& formula, ClauseRef ref, const Assignments& assignments) {
+        const Literal& first = formula.clause(ref)[0];
+        return assignments.value(first) && assignments.reason(first.variable()) == ref;
+    }
+
+    static void detach_removed(const Formula& formula, Watches& watches) {
+        for (vector<vector<Watcher>>* lists : {&watches.lists, &watches.binaries}) {
+            for (vector<Watcher>& ws : *lists) {
+                ws.erase(remove_if(ws.begin(), ws.end(),
+                                   [&](const Watcher& w) { return formula.clause(w.clause).removed; }),
+                         ws.end());
+            }
+        }
+    }
+
+    // Compacts the arena in place and rewrites all references to the moved clauses. Watchers
+    // of removed clauses are detached by now; other references to them are dropped.
+    void collect_garbage(Formula& formula, Assignments& assignments, Watches& watches) {
+        ClauseArena& arena = formula.arena;
+        arena.plan_compaction();
+        for (vector<vector<Watcher>>* lists : {&watches.lists, &watches.binaries}) {
+            for (vector<Watcher>& ws : *lists) {
+                for (Watcher& w : ws) w.clause = arena.forward(w.clause);
+            }
+        }
+        for (const Literal& lit : assignments.trail) {
+            ClauseRef& reason = assignments.reasons[lit.variable()];
+            if (reason != NO_REASON) reason = arena.forward(reason);
+        }
+        for (vector<ClauseRef>* refs : {&formula.clauses, &core, &tier2, &local}) {
+            size_t kept = 0;
+            for (ClauseRef ref : *refs) {
+                ClauseRef to = arena.forward(ref);
+                if (to != NO_REASON) (*refs)[kept++] = to;
+            }
+            refs->resize(kept);
+        }
+        if (proof) proof->relocate(arena);
+        arena.compact();
+    }
+};
+
+// One bit per decision level (modulo 32), so a set of levels fits in a word.
+uint32_t abstract_level(int level) {
+    return 1u << (level & 31);
+}
+
+// Buffers conflict analysis keeps from one conflict to the next, so that it allocates nothing
+// once they have grown: per-variable seen flags, the variables flagged so far, the learned
+// clause and the stacks of the redundancy check.
+struct AnalysisScratch {
+    vector<uint8_t> seen;
+    vector<int> touched;  // variables with seen set, cleared at the end of each analysis
+    vector<Literal> learned;
+    vector<Literal> stack;
+    vector<int> marked;
+
+    void mark(int var) {
+        seen[var] = 1;
+        touched.push_back(var);
+    }
+};
+
+// Checks whether lit is implied by the other literals of the learned clause, i.e. whether
+// every path back through its antecedents ends in a literal already in the clause (marked
+// seen) or at level 0. Variables proven redundant stay marked to prune later searches; a
+// path that reaches a decision, or a level absent from abstract_levels, fails early.
+bool literal_redundant(const Formula& formula, Literal lit, uint32_t abstract_levels, const Assignments& assignments,
+                       AnalysisScratch& scratch) {
+    vector<Literal>& stack = scratch.stack;
+    vector<int>& marked = scratch.marked;
+    stack.assign(1, lit);
+    marked.clear();
+    while (!stack.empty()) {
+        int var = stack.back().variable();
+        stack.pop_back();
+        for (const Literal& q : formula.clause(assignments.reason(var))) {
+            int v = q.variable();
+            if (v == var || assignments.level(v) == 0 || scratch.seen[v]) continue;
+            if (assignments.reason(v) == NO_REASON || !(abstract_level(assignments.level(v)) & abstract_levels)) {
+                for (int m : marked) scratch.seen[m] = 0;
+                return false;
+            }
+            scratch.mark(v);
+            marked.push_back(v);
+            stack.push_back(q);
+        }
+    }
+    return true;
+}
+
+// Derives the first-UIP clause of conflict into scratch.learned, with the UIP first and
+// a literal of the backjump level second; returns that level, or -1 at level 0.
+int conflict_analysis(Formula& formula, ClauseRef conflict, const Assignments& assignments, VarOrder& order,
+                      ClauseDatabase& db, const SolverOptions& options, AnalysisScratch& scratch) {
+    if (assignments.decision_level() == 0) return -1;
+
+    // Resolve the conflict backwards along the trail until exactly one literal of the
+    // current decision level remains: the first unique implication point.
+    if (scratch.seen.size() < assignments.values.size()) scratch.seen.resize(assignments.values.size(), 0);
+    vector<uint8_t>& seen = scratch.seen;
+    vector<Literal>& learned = scratch.learned;
+    learned.assign(1, Literal());  // slot 0 is reserved for the UIP
+    int pending = 0;
+    ClauseRef reason = conflict;
+    optional<int> pivot;
+    size_t index = assignments.trail.size();
+    Literal uip;
+
+    while (true) {
+        if (formula.clause(reason).learnt) db.on_used(formula, reason, assignments);
+        for (const Literal& lit : formula.clause(reason)) {
+            if (pivot && lit.variable() == *pivot) continue;
+            if (seen[lit.variable()]) continue;
+            scratch.mark(lit.variable());
+            int level = assignments.level(lit.variable());
+            if (level > 0) order.bump(lit.variable());
+            if (level == assignments.decision_level()) {
+                ++pending;
+            } else if (level > 0) {
+                learned.push_back(lit);
+            }
+        }
+
+        // Out-of-order assignments of lower levels can sit among those of the conflict level.
+        do {
+            --index;
+        } while (!seen[assignments.trail[index].variable()] ||
+                 assignments.level(assignments.trail[index].variable()) != assignments.decision_level());
+        uip = assignments.trail[index];
+        if (--pending == 0) break;
+
+        pivot = uip.variable();
+        reason = assignments.reason(uip.variable());
+    }
+    learned[0] = uip.neg();
+
+    if (options.minimize_learned) {
+        uint32_t abstract_levels = 0;
+        for (size_t i = 1; i < learned.size(); ++i) {
+            abstract_levels |= abstract_level(assignments.level(learned[i].variable()));
+        }
+        size_t kept = 1;
+        for (size_t i = 1; i < learned.size(); ++i) {
+            int var = learned[i].variable();
+            if (assignments.reason(var) == NO_REASON ||
+                !literal_redundant(formula, learned[i], abstract_levels, assignments, scratch)) {
+                learned[kept++] = learned[i];
+            }
+        }
+        learned.resize(kept);
+    }
+
+    // Backjump to the second-highest level in the clause, where it becomes unit on the UIP.
+    int decision_level = 0;
+    size_t second = 1;
+    for (size_t i = 1; i < learned.size(); ++i) {
+        int level = assignments.level(learned[i].variable());
+        if (level > decision_level) {
+            decision_level = level;
+            second = i;
+        }
+    }
+    if (learned.size() > 1) swap(learned[1], learned[second]);
+
+    for (int var : scratch.touched) seen[var] = 0;
+    scratch.touched.clear();
+    return decision_level;
+}
+
+// Solver snapshots are a magic string, a format version and a byte-order mark, then raw values
+// and arrays in a fixed order. Each array follows its element count, padded to start on 8 bytes,
+// so that a mapped snapshot loads with one aligned copy per array. SNAPSHOT_VERSION changes with the layout.
+const char SNAPSHOT_MAGIC[8] = {'S', 'A', 'T', 'S', 'N', 'A', 'P', '\n'};
+const uint32_t SNAPSHOT_VERSION = 1;
+const uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304;
+
+// Writes a snapshot next to path and renames it over path once complete, so that a crash or
+// a full disk never leaves a torn snapshot in its place.
+class SnapshotWriter {
+public:
+    explicit SnapshotWriter(const string& path)
+        : path(path), temporary(path + ".tmp"), file(fopen(temporary.c_str(), "wb")), written(0) {
+        if (!file) throw runtime_error("cannot write " + temporary);
+        setvbuf(file, nullptr, _IOFBF, 1 << 20);
+        write(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+        put(SNAPSHOT_VERSION);
+        put(SNAPSHOT_BYTE_ORDER);
+    }
+
+    ~SnapshotWriter() {
+        if (!file) return;
+        fclose(file);
+        remove(temporary.c_str());
+    }
+
+    SnapshotWriter(const SnapshotWriter&) = delete;
+    SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+
+    template <typename T>
+    void put(const T& value) {
+        static_assert(is_trivially_copyable_v<T>, "snapshots hold raw values");
+        write(&value, sizeof(T));
+    }
+
+    template <typename T>
+    void put(const vector<T>& values) {
+        static_assert(is_trivially_copyable_v<T>, "snapshots hold raw values");
+        put<uint64_t>(values.size());
+        static const char zeros[8] = {};
+        write(zeros, (8 - written % 8) % 8);
+        write(values.data(), values.size() * sizeof(T));
+    }
+
+    void commit() {
+        bool ok = fflush(file) == 0 && fsync(fileno(file)) == 0;
+        ok = fclose(file) == 0 && ok;
+        file = nullptr;
+        if (!ok || rename(temporary.c_str(), path.c_str()) != 0) {
+            remove(temporary.c_str());
+            throw runtime_error("cannot write " + path);
+        }
+    }
+
+private:
+    string path;
+    string temporary;
+    FILE* file;
+    size_t written;
+
+    void write(const void* data, size_t bytes) {
+        if (bytes && fwrite(data, 1, bytes, file) != bytes) throw runtime_error("cannot write " + temporary);
+        written += bytes;
+    }
+};
+
+// A snapshot mapped read-only; get() copies the values out in the order they were put.
+class SnapshotReader {
+public:
+    explicit SnapshotReader(const string& path) : path(path), data(nullptr), size(0), at(0) {
+        int fd = open(path.c_str(), O_RDONLY);
+        struct stat info;
+        if (fd < 0 || fstat(fd, &info) != 0) {
+            if (fd >= 0) close(fd);
+            throw runtime_error("cannot open " + path);
+        }
+        size = static_cast<size_t>(info.st_size);
+        void* mapped = size ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+        close(fd);
+        if (mapped == MAP_FAILED) throw runtime_error("cannot map " + path);
+        madvise(mapped, size, MADV_SEQUENTIAL);
+        data = static_cast<const char*>(mapped);
+        char magic[sizeof(SNAPSHOT_MAGIC)];
+        read(magic, sizeof(magic));
+        if (memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic)) != 0) fail("is not a solver snapshot");
+        if (get<uint32_t>() != SNAPSHOT_VERSION) fail("is a snapshot of another format version");
+        if (get<uint32_t>() != SNAPSHOT_BYTE_ORDER) fail("was written with another byte order");
+    }
+
+    ~SnapshotReader() {
+        if (data) munmap(const_cast<char*>(data), size);
+    }
+
+    SnapshotReader(const SnapshotReader&) = delete;
+    SnapshotReader& operator=(const SnapshotReader&) = delete;
+
+    template <typename T>
+    T get() {
+        T value;
+        read(&value, sizeof(T));
+        return value;
+    }
+
+    template <typename T>
+    void get(vector<T>& values) {
+        uint64_t count = get<uint64_t>();
+        at = min(size, (at + 7) & ~static_cast<size_t>(7));
+        if (count > (size - at) / sizeof(T)) fail("is truncated");
+        const T* begin = reinterpret_cast<const T*>(data + at);
+        values.assign(begin, begin + count);
+        at += count * sizeof(T);
+    }
+
+    // As get(values), for a table indexed by variable that must hold one entry per variable.
+    template <typename T>
+    void get(vector<T>& values, size_t expected) {
+        get(values);
+        if (values.size() != expected) fail("is corrupt");
+    }
+
+    // Checks that everything was read.
+    void finish() {
+        if (at != size) fail("is corrupt");
+    }
+
+    [[noreturn]] void fail(const string& reason) const {
+        throw runtime_error(path + " " + reason);
+    }
+
+private:
+    string path;
+    const char* data;
+    size_t size;
+    size_t at;
+
+    void read(void* out, size_t bytes) {
+        if (bytes > size - at) fail("is truncated");
+        memcpy(out, data + at, bytes);
+        at += bytes;
+    }
+};
+
+// SatELite-style simplification run between parsing and search: level-0 unit propagation,
+// backward subsumption, self-subsuming strengthening and bounded variable elimination, all
+// driven by occurrence lists. Clauses removed by elimination go on a reconstruction stack
+// that extend_model replays to give eliminated variables values satisfying them.
+class Preprocessor {
+public:
+    Preprocessor(Formula& formula, const SolverOptions& options, Proof* proof = nullptr)
+        : formula(formula), options(options), proof(proof), occurs(2 * static_cast<size_t>(formula.max_variable) + 2),
+          fixed(formula.max_variable + 1, -1), eliminated(formula.max_variable + 1, 0),
+          frozen(formula.max_variable + 1, 0), touched(formula.max_variable + 1, 0), marks(2 * static_cast<size_t>(formula.max_variable) + 2, 0),
+          units_head(0), queue_head(0), steps(0) {}
+
+    // Simplifies formula in place; returns false if it was found unsatisfiable.
+    bool run() {
+        vector<ClauseRef> input;
+        input.swap(formula.clauses);
+        for (ClauseRef ref : input) {
+            const Clause& clause = formula.clause(ref);
+            if (!add(clause, false)) return false;
+        }
+        if (!propagate()) return false;
+
+        bool progress = true;
+        while (progress && steps < options.preprocess_steps) {
+            if (!subsume()) return false;
+            size_t before = eliminated_count;
+            if (!eliminate()) return false;
+            progress = eliminated_count > before;
+        }
+        rebuild();
+        return true;
+    }
+
+    bool is_eliminated(int var) const {
+        return static_cast<size_t>(var) < eliminated.size() && eliminated[var];
+    }
+
+    // Keeps var out of elimination, e.g. because it is assumed by the caller.
+    void freeze(int var) {
+        if (static_cast<size_t>(var) < frozen.size()) frozen[var] = 1;
+    }
+
+    // Undoes every elimination, for clauses or assumptions added later on eliminated variables:
+    // returns the clauses elimination removed, on both sides of each variable, appends the
+    // variables to restored and forgets the reconstruction stack.
+    vector<vector<Literal>> restore(vector<int>& restored) {
+        vector<vector<Literal>> clauses;
+        for (const Extension& entry : eliminated_clauses) {
+            auto begin = eliminated_literals.begin() + static_cast<ptrdiff_t>(entry.start);
+            clauses.emplace_back(begin, begin + static_cast<ptrdiff_t>(entry.size));
+        }
+        for (size_t var = 1; var < eliminated.size(); ++var) {
+            if (eliminated[var]) restored.push_back(static_cast<int>(var));
+            eliminated[var] = 0;
+        }
+        eliminated_literals.clear();
+        eliminated_clauses.clear();
+        extension_literals.clear();
+        extension.clear();
+        return clauses;
+    }
+
+    // Gives eliminated variables values that satisfy every clause removed with them,
+    // replaying the reconstruction stack from the most recent elimination backwards.
+    void extend_model(Assignments& assignments) const {
+        for (size_t var = 1; var < eliminated.size(); ++var) {
+            if (eliminated[var] && !assignments.is_assigned(static_cast<int>(var))) {
+                assignments.assign(static_cast<int>(var), false, NO_REASON);
+            }
+        }
+        for (size_t i = extension.size(); i-- > 0;) {
+            const Extension& entry = extension[i];
+            bool satisfied = false;
+            for (size_t k = 0; k < entry.size && !satisfied; ++k) {
+                satisfied = assignments.value(extension_literals[entry.start + k]);
+            }
+            if (!satisfied) {
+                const Literal& witness = extension_literals[entry.start];
+                assignments.values[witness.variable()] = witness.negation() ? 0 : 1;
+            }
+        }
+    }
+
+    // The reconstruction stack and the clauses restore() gives back, for solver snapshots.
+    void save(SnapshotWriter& out) const {
+        out.put(eliminated);
+        out.put(extension_literals);
+        out.put(extension);
+        out.put(eliminated_literals);
+        out.put(eliminated_clauses);
+        out.put<uint64_t>(eliminated_count);
+        out.put<uint64_t>(removed_clauses);
+    }
+
+    void load(SnapshotReader& in) {
+        in.get(eliminated, static_cast<size_t>(formula.max_variable) + 1);
+        in.get(extension_literals);
+        in.get(extension);
+        in.get(eliminated_literals);
+        in.get(eliminated_clauses);
+        eliminated_count = in.get<uint64_t>();
+        removed_clauses = in.get<uint64_t>();
+        for (const vector<Literal>* lits : {&extension_literals, &eliminated_literals}) {
+            for (const Literal& lit : *lits) {
+                if (lit.variable() < 1 || lit.variable() > formula.max_variable) in.fail("is corrupt");
+            }
+        }
+        for (const vector<Extension>* entries : {&extension, &eliminated_clauses}) {
+            size_t available = (entries == &extension ? extension_literals : eliminated_literals).size();
+            for (const Extension& entry : *entries) {
+                if (entry.start > available || entry.size > available - entry.start ||
+                    (entries == &extension && entry.size == 0)) {
+                    in.fail("is corrupt");
+                }
+            }
+        }
+    }
+
+    size_t eliminated_count = 0;
+    size_t removed_clauses = 0;
+
+private:
+    static constexpr size_t OCCURRENCE_LIMIT = 10;  // skip elimination when both sides occur more often
+    static constexpr size_t RESOLVENT_LIMIT = 20;   // and when a resolvent would be longer than this
+
+    // A removed clause, stored with the literal of its eliminated variable first.
+    struct Extension {
+        size_t start;
+        size_t size;
+    };
+
+    Formula& formula;
+    SolverOptions options;
+    Proof* proof;                           // receives every added, strengthened and removed clause if set
+    vector<ClauseRef> refs;                 // clause id -> arena reference
+    vector<uint64_t> signatures;            // clause id -> bitmask of its variables modulo 64
+    vector<uint8_t> dead;                   // clause id -> removed, kept dense for cheap occurrence scans
+    vector<vector<uint32_t>> occurs;        // literal -> ids of clauses containing it (pruned lazily)
+    vector<int8_t> fixed;                   // values implied at level 0, -1 while open
+    vector<uint8_t> eliminated;
+    vector<uint8_t> frozen;                 // variables that must survive elimination
+    vector<uint8_t> touched;                // variables whose occurrences changed since they were last tried
+    vector<uint8_t> marks;                  // per-literal scratch flags
+    vector<Literal> units;
+    size_t units_head;
+    vector<uint32_t> queue;                 // clauses to use for backward subsumption
+    vector<uint8_t> queued;
+    size_t queue_head;
+    vector<Literal> extension_literals;
+    vector<Extension> extension;
+    vector<Literal> eliminated_literals;    // every clause elimination removed, for restore()
+    vector<Extension> eliminated_clauses;
+    uint64_t steps;
+    vector<Literal> scratch;                // literals of the clause being added
+    vector<Literal> shortened;              // literals of the clause being strengthened, for the proof
+    vector<uint32_t> candidates;            // clauses checked against the current subsumer
+
+    Clause& clause(uint32_t id) {
+        return formula.clause(refs[id]);
+    }
+
+    bool removed(uint32_t id) const {
+        return dead[id];
+    }
+
+    static uint64_t signature_bit(const Literal& lit) {
+        return uint64_t(1) << (lit.variable() & 63);
+    }
+
+    uint64_t compute_signature(const Clause& c) const {
+        uint64_t signature = 0;
+        for (const Literal& lit : c) signature |= signature_bit(lit);
+        return signature;
+    }
+
+    int8_t fixed_value(const Literal& lit) const {
+        int8_t value = fixed[lit.variable()];
+        if (value < 0) return -1;
+        return lit.negation() ? 1 - value : value;
+    }
+
+    // Records lit as true at level 0; returns false if it is already false.
+    bool fix(const Literal& lit) {
+        int8_t value = fixed_value(lit);
+        if (value == 0) return false;
+        if (value < 0) {
+            fixed[lit.variable()] = lit.negation() ? 0 : 1;
+            units.push_back(lit);
+            touched[lit.variable()] = 1;
+        }
+        return true;
+    }
+
+    void enqueue(uint32_t id) {
+        if (id >= queued.size()) queued.resize(id + 1, 0);
+        if (queued[id]) return;
+        queued[id] = 1;
+        queue.push_back(id);
+    }
+
+    // Adds a clause after dropping duplicate and level-0 false literals; satisfied clauses
+    // and tautologies are skipped and units are fixed. Returns false on an empty clause.
+    // Derived clauses are new to the proof; input clauses only go there if simplified.
+    template <typename Lits>
+    bool add(const Lits& lits, bool derived) {
+        vector<Literal>& kept = scratch;
+        kept.clear();
+        bool skip = false;
+        for (const Literal& lit : lits) {
+            int8_t value = fixed_value(lit);
+            if (value == 1 || marks[lit.neg().index()]) skip = true;
+            if (skip) break;
+            if (value == 0 || marks[lit.index()]) continue;
+            marks[lit.index()] = 1;
+            kept.push_back(lit);
+        }
+        for (const Literal& lit : kept) marks[lit.index()] = 0;
+        if (proof) {
+            bool changed = skip || kept.size() != lits.size();
+            if (!skip && (derived || changed)) proof->add(kept);
+            if (!derived && changed) proof->remove(lits);
+        }
+        if (skip) return true;
+        if (kept.empty()) return false;
+        if (kept.size() == 1) return fix(kept[0]);
+
+        uint32_t id = static_cast<uint32_t>(refs.size());
+        refs.push_back(formula.arena.alloc(kept, false));
+        signatures.push_back(compute_signature(clause(id)));
+        dead.push_back(0);
+        for (const Literal& lit : kept) {
+            occurs[lit.index()].push_back(id);
+            touched[lit.variable()] = 1;
+        }
+        enqueue(id);
+        return true;
+    }
+
+    void remove_clause(uint32_t id) {
+        if (removed(id)) return;
+        // Units stay in the proof, as they stay fixed here.
+        if (proof && clause(id).size() > 1) proof->remove(clause(id));
+        for (const Literal& lit : clause(id)) touched[lit.variable()] = 1;
+        formula.arena.free(refs[id]);
+        dead[id] = 1;
+        ++removed_clauses;
+    }
+
+    // The live clauses containing lit, dropping stale entries of removed clauses.
+    vector<uint32_t>& live_occurs(const Literal& lit) {
+        vector<uint32_t>& list = occurs[lit.index()];
+        list.erase(remove_if(list.begin(), list.end(), [&](uint32_t id) { return removed(id); }), list.end());
+        return list;
+    }
+
+    // Removes lit from clause id. Its occurrence entry is left for the caller to drop.
+    bool strengthen(uint32_t id, const Literal& lit) {
+        Clause& c = clause(id);
+        if (proof) {
+            shortened.clear();
+            for (const Literal& other : c) {
+                if (other != lit) shortened.push_back(other);
+            }
+            proof->add(shortened);
+            proof->remove(c);
+        }
+        for (size_t i = 0; i < c.size(); ++i) {
+            if (c[i] == lit) {
+                c[i] = c[c.size() - 1];
+                formula.arena.shrink(refs[id], c.size() - 1);
+                break;
+            }
+        }
+        touched[lit.variable()] = 1;
+        if (c.size() == 1) {
+            Literal unit = c[0];
+            remove_clause(id);
+            return fix(unit);
+        }
+        signatures[id] = compute_signature(c);
+        enqueue(id);
+        return true;
+    }
+
+    bool propagate() {
+        while (units_head < units.size()) {
+            Literal lit = units[units_head++];
+            for (uint32_t id : occurs[lit.index()]) remove_clause(id);
+            occurs[lit.index()].clear();
+            vector<uint32_t> falsified;
+            falsified.swap(occurs[lit.neg().index()]);
+            for (uint32_t id : falsified) {
+                if (!removed(id) && !strengthen(id, lit.neg())) return false;
+            }
+        }
+        return true;
+    }
+
+    // Whether c subsumes d, possibly after removing one literal. On success pivot is
+    // Literal() for plain subsumption, or the literal of c whose negation d can drop.
+    bool subsumes(const Clause& c, const Clause& d, Literal& pivot) {
+        pivot = Literal();
+        steps += c.size() * d.size();
+        for (const Literal& lit : c) {
+            bool found = false;
+            for (const Literal& other : d) {
+                if (other == lit) {
+                    found = true;
+                    break;
+                }
+                if (pivot == Literal() && other == lit.neg()) {
+                    pivot = lit;
+                    found = true;
+                    break;
+                }
+            }
+            if (!found) return false;
+        }
+        return true;
+    }
+
+    // Backward subsumption and self-subsuming strengthening with every queued clause.
+    bool subsume() {
+        while (queue_head < queue.size() && steps < options.preprocess_steps) {
+            uint32_t id = queue[queue_head++];
+            queued[id] = 0;
+            if (removed(id)) continue;
+
+            // Every clause subsumed or strengthened by c contains its rarest variable.
+            Literal best = clause(id)[0];
+            size_t best_count = SIZE_MAX;
+            for (const Literal& lit : clause(id)) {
+                size_t count = occurs[lit.index()].size() + occurs[lit.neg().index()].size();
+                if (count < best_count) {
+                    best = lit;
+                    best_count = count;
+                }
+            }
+
+            for (const Literal& side : {best, best.neg()}) {
+                candidates = live_occurs(side);
+                filter_signatures(candidates, signatures.data(), signatures[id]);
+                for (uint32_t other : candidates) {
+                    if (other == id || removed(other) || removed(id)) continue;
+                    if (clause(other).size() < clause(id).size()) continue;
+                    Literal pivot;
+                    if (!subsumes(clause(id), clause(other), pivot)) continue;
+                    if (pivot == Literal()) {
+                        remove_clause(other);
+                        continue;
+                    }
+                    vector<uint32_t>& list = occurs[pivot.neg().index()];
+                    auto entry = find(list.begin(), list.end(), other);
+                    if (entry != list.end()) list.erase(entry);
+                    if (!strengthen(other, pivot.neg())) return false;
+                }
+            }
+            if (!propagate()) return false;
+        }
+        queue.erase(queue.begin(), queue.begin() + queue_head);
+        queue_head = 0;
+        return true;
+    }
+
+    // Writes the resolvent of clauses a and b on var into out; false for a tautology.
+    bool resolve(uint32_t a, uint32_t b, int var, vector<Literal>& out) {
+        out.clear();
+        for (const Literal& lit : clause(a)) {
+            if (lit.variable() == var) continue;
+            marks[lit.index()] = 1;
+            out.push_back(lit);
+        }
+        bool tautology = false;
+        for (const Literal& lit : clause(b)) {
+            if (lit.variable() == var || marks[lit.index()]) continue;
+            if (marks[lit.neg().index()]) {
+                tautology = true;
+                break;
+            }
+            out.push_back(lit);
+        }
+        for (const Literal& lit : clause(a)) marks[lit.index()] = 0;
+        steps += clause(a).size() + clause(b).size();
+        return !tautology;
+    }
+
+    void push_extension(uint32_t id, const Literal& witness) {
+        extension.push_back({extension_literals.size(), clause(id).size()});
+        extension_literals.push_back(witness);
+        for (const Literal& lit : clause(id)) {
+            if (lit != witness) extension_literals.push_back(lit);
+        }
+    }
+
+    // Replaces the clauses of var by their non-tautological resolvents when that does not
+    // increase the clause count.
+    bool try_eliminate(int var) {
+        if (frozen[var]) return true;
+        Literal positive(var, false);
+        vector<uint32_t> pos = live_occurs(positive);
+        vector<uint32_t> neg = live_occurs(positive.neg());
+        if (pos.empty() && neg.empty()) return true;
+        if (pos.size() > OCCURRENCE_LIMIT && neg.size() > OCCURRENCE_LIMIT) return true;
+
+        // Resolvents are stored back to back, each preceded by its length.
+        vector<uint32_t> resolvents;
+        vector<Literal> resolvent;
+        size_t count = 0;
+        for (uint32_t a : pos) {
+            for (uint32_t b : neg) {
+                if (!resolve(a, b, var, resolvent)) continue;
+                if (++count > pos.size() + neg.size() || resolvent.size() > RESOLVENT_LIMIT) return true;
+                resolvents.push_back(static_cast<uint32_t>(resolvent.size()));
+                for (const Literal& lit : resolvent) resolvents.push_back(lit.code);
+            }
+        }
+
+        // Keep the smaller side plus a unit for the other polarity, which extend_model
+        // replays first as the default and then corrects from the stored clauses.
+        bool keep_positive = pos.size() <= neg.size();
+        const vector<uint32_t>& kept_side = keep_positive ? pos : neg;
+        Literal witness = keep_positive ? positive : positive.neg();
+        for (uint32_t id : kept_side) push_extension(id, witness);
+        extension.push_back({extension_literals.size(), 1});
+        extension_literals.push_back(witness.neg());
+
+        eliminated[var] = 1;
+        ++eliminated_count;
+        for (const vector<uint32_t>* side : {&pos, &neg}) {
+            for (uint32_t id : *side) {
+                eliminated_clauses.push_back({eliminated_literals.size(), clause(id).size()});
+                eliminated_literals.insert(eliminated_literals.end(), clause(id).begin(), clause(id).end());
+            }
+        }
+        // Resolvents first, so that a proof derives them before their antecedents are deleted.
+        for (size_t i = 0; i < resolvents.size(); i += resolvents[i] + 1) {
+            vector<Literal> lits(resolvents[i]);
+            for (size_t k = 0; k < lits.size(); ++k) lits[k].code = resolvents[i + 1 + k];
+            if (!add(lits, true)) return false;
+        }
+        for (uint32_t id : pos) remove_clause(id);
+        for (uint32_t id : neg) remove_clause(id);
+        occurs[positive.index()].clear();
+        occurs[positive.neg().index()].clear();
+        return propagate();
+    }
+
+    bool eliminate() {
+        vector<int> candidates;
+        for (size_t var = 1; var < touched.size(); ++var) {
+            if (touched[var] && !eliminated[var] && fixed[var] < 0) candidates.push_back(static_cast<int>(var));
+            touched[var] = 0;
+        }
+        auto cost = [&](int var) {
+            Literal lit(var, false);
+            return occurs[lit.index()].size() * occurs[lit.neg().index()].size();
+        };
+        sort(candidates.begin(), candidates.end(), [&](int a, int b) { return cost(a) < cost(b); });
+        for (int var : candidates) {
+            if (steps >= options.preprocess_steps) break;
+            if (eliminated[var] || fixed[var] >= 0) continue;
+            if (!try_eliminate(var)) return false;
+        }
+        return true;
+    }
+
+    // Compacts the surviving clauses into a fresh arena; fixed variables become unit clauses.
+    void rebuild() {
+        ClauseArena arena;
+        vector<ClauseRef> clauses;
+        for (Literal lit : units) clauses.push_back(arena.alloc(vector<Literal>{lit}, false));
+        for (uint32_t id = 0; id < refs.size(); ++id) {
+            if (!removed(id)) clauses.push_back(arena.alloc(clause(id), false));
+        }
+        formula.arena = move(arena);
+        formula.clauses = move(clauses);
+    }
+};
+
+// Learned-clause bus between portfolio workers. Every worker publishes into its own ring of
+// fixed-size slots (single producer) that all other workers read without locks: a slot's
+// sequence number is odd while it is being written, and readers that see it change under them
+// or find a slot already overwritten by a lapping producer simply skip it. A shared table of
+// clause hashes drops clauses some worker has published recently.
+class ClauseExchange {
+public:
+    static constexpr size_t MAX_SIZE = 16;        // longest clause a slot can hold
+    static constexpr size_t RING_SIZE = 1024;     // slots per worker before the oldest are overwritten
+    static constexpr size_t FILTER_SIZE = 1 << 16;
+
+    ClauseExchange(unsigned workers) : rings(workers), filter(FILTER_SIZE) {
+        for (unique_ptr<Ring>& ring : rings) ring = make_unique<Ring>();
+        for (atomic<uint64_t>& hash : filter) hash.store(0, memory_order_relaxed);
+    }
+
+    size_t workers() const {
+        return rings.size();
+    }
+
+    // Called only by worker from, with a clause of at most MAX_SIZE literals.
+    void publish(unsigned from, const vector<Literal>& lits, unsigned lbd) {
+        assert(lits.size() <= MAX_SIZE);
+        uint64_t hash = clause_hash(lits);
+        atomic<uint64_t>& entry = filter[hash % FILTER_SIZE];
+        if (entry.exchange(hash, memory_order_relaxed) == hash) return;
+
+        Ring& ring = *rings[from];
+        uint64_t position = ring.head.load(memory_order_relaxed);
+        Slot& slot = ring.slots[position % RING_SIZE];
+        slot.sequence.store(2 * position + 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+        slot.size.store(static_cast<uint32_t>(lits.size()), memory_order_relaxed);
+        slot.lbd.store(lbd, memory_order_relaxed);
+        for (size_t i = 0; i < lits.size(); ++i) slot.lits[i].store(lits[i].code, memory_order_relaxed);
+        slot.sequence.store(2 * position + 2, memory_order_release);
+        ring.head.store(position + 1, memory_order_release);
+    }
+
+    // Hands every clause published by the other workers since the last call to on_clause(lits, lbd).
+    // cursors holds the reader's position in each ring.
+    template <typename OnClause>
+    void collect(unsigned to, vector<uint64_t>& cursors, OnClause&& on_clause) const {
+        cursors.resize(rings.size(), 0);
+        vector<Literal> lits;
+        for (unsigned from = 0; from < rings.size(); ++from) {
+            if (from == to) continue;
+            const Ring& ring = *rings[from];
+            uint64_t head = ring.head.load(memory_order_acquire);
+            uint64_t& cursor = cursors[from];
+            if (head - cursor > RING_SIZE) cursor = head - RING_SIZE;
+            for (; cursor < head; ++cursor) {
+                const Slot& slot = ring.slots[cursor % RING_SIZE];
+                uint64_t sequence = slot.sequence.load(memory_order_acquire);
+                if (sequence != 2 * cursor + 2) continue;
+                uint32_t size = min<uint32_t>(slot.size.load(memory_order_relaxed), MAX_SIZE);
+                unsigned lbd = slot.lbd.load(memory_order_relaxed);
+                lits.resize(size);
+                for (uint32_t i = 0; i < size; ++i) lits[i].code = slot.lits[i].load(memory_order_relaxed);
+                atomic_thread_fence(memory_order_acquire);
+                if (slot.sequence.load(memory_order_relaxed) != sequence) continue;
+                on_clause(lits, lbd);
+            }
+        }
+    }
+
+private:
+    struct Slot {
+        atomic<uint64_t> sequence{0};
+        atomic<uint32_t> size{0};
+        atomic<uint32_t> lbd{0};
+        atomic<uint32_t> lits[MAX_SIZE] = {};
+    };
+
+    struct Ring {
+        atomic<uint64_t> head{0};
+        Slot slots[RING_SIZE];
+    };
+
+    vector<unique_ptr<Ring>> rings;
+    vector<atomic<uint64_t>> filter;
+
+    // Order-independent, so the same clause learned by two workers hashes alike; never 0,
+    // which marks an empty filter entry.
+    static uint64_t clause_hash(const vector<Literal>& lits) {
+        uint64_t sum = 0, mix = 0;
+        for (const Literal& lit : lits) {
+            uint64_t h = (lit.code + 1) * 0x9e3779b97f4a7c15ull;
+            h ^= h >> 29;
+            sum += h;
+            mix ^= h * 0xbf58476d1ce4e5b9ull;
+        }
+        return (sum ^ (mix >> 1) ^ lits.size()) | 1;
+    }
+};
+
+// Outcome of a search; UNKNOWN when a budget, an interrupt or a stop request ended it first.
+enum class SolveStatus { SATISFIABLE, UNSATISFIABLE, UNKNOWN };
+
+const char* status_name(SolveStatus status) {
+    return status == SolveStatus::SATISFIABLE ? "SAT" : status == SolveStatus::UNSATISFIABLE ? "UNSAT" : "UNKNOWN";
+}
+
+// Work counters and phase times of one solver, summed over its solve calls. Each solver
+// updates its own copy only, so portfolio workers never share a cache line for statistics.
+struct SolverStats {
+    uint64_t conflicts = 0;
+    uint64_t decisions = 0;
+    uint64_t propagations = 0;
+    uint64_t restarts = 0;
+    uint64_t learned = 0;          // clauses learned from conflicts
+    uint64_t deleted = 0;          // learned clauses dropped by reductions
+    uint64_t lbd_sum = 0;          // over the learned clauses
+    uint64_t trail_sum = 0;        // trail length at each conflict
+    uint64_t walks = 0;            // local search runs
+    uint64_t flips = 0;            // and the variables they flipped
+    double simplify_seconds = 0;   // preprocessing, probing and attaching clauses before the first search
+    double search_seconds = 0;
+    // Scoped timers, only kept with SolverOptions::timers.
+    double propagate_seconds = 0;  // unit propagation during search
+    double analyze_seconds = 0;    // conflict analysis
+    double reduce_seconds = 0;     // learned clause reduction and garbage collection
+    double preprocess_seconds = 0;
+    double inprocess_seconds = 0;
+    double walk_seconds = 0;       // local search
+    const char* limit = nullptr;   // the budget that ended the last solve call with UNKNOWN, if any
+
+    double average_lbd() const {
+        return learned ? static_cast<double>(lbd_sum) / learned : 0;
+    }
+
+    double average_trail() const {
+        return conflicts ? static_cast<double>(trail_sum) / conflicts : 0;
+    }
+
+    string to_json() const {
+        stringstream ss;
+        ss << fixed << setprecision(3) << "{\"conflicts\": " << conflicts << ", \"decisions\": " << decisions
+           << ", \"propagations\": " << propagations << ", \"restarts\": " << restarts << ", \"learned\": " << learned
+           << ", \"deleted\": " << deleted << ", \"average_lbd\": " << average_lbd()
+           << ", \"average_trail\": " << average_trail() << ", \"walks\": " << walks << ", \"flips\": " << flips
+           << ", \"simplify_s\": " << simplify_seconds
+           << ", \"search_s\": " << search_seconds << ", \"propagate_s\": " << propagate_seconds
+           << ", \"analyze_s\": " << analyze_seconds << ", \"reduce_s\": " << reduce_seconds
+           << ", \"preprocess_s\": " << preprocess_seconds << ", \"inprocess_s\": " << inprocess_seconds
+           << ", \"walk_s\": " << walk_seconds;
+        if (limit) ss << ", \"limit\": \"" << limit << "\"";
+        ss << "}";
+        return ss.str();
+    }
+};
+
+struct SolveResult {
+    SolveStatus status;
+    optional<Assignments> model;  // set when SATISFIABLE
+    vector<SolverStats> stats;    // one entry per solver that took part
+};
+
+const SolveResult UNSAT_RESULT = {SolveStatus::UNSATISFIABLE, nullopt, {}};
+const SolveResult UNKNOWN_RESULT = {SolveStatus::UNKNOWN, nullopt, {}};
+
+double seconds_since(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// Adds the time until the end of its scope to *total; reads no clock if total is null.
+class ScopedTimer {
+public:
+    explicit ScopedTimer(double* total) : total(total) {
+        if (total) start = chrono::steady_clock::now();
+    }
+
+    ~ScopedTimer() {
+        if (total) *total += seconds_since(start);
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    double* total;
+    chrono::steady_clock::time_point start;
+};
+
+// Raised by SIGUSR1; every solver prints its statistics when it sees the count change.
+atomic<unsigned> stats_requests(0);
+static_assert(atomic<unsigned>::is_always_lock_free, "stats_requests is updated from a signal handler");
+
+void request_stats(int) {
+    stats_requests.fetch_add(1, memory_order_relaxed);
+}
+
+// Raised by the first SIGINT or SIGTERM: every solver gives up with UNKNOWN at its next decision,
+// so the answer and statistics so far are still reported. A second signal kills the process.
+atomic<bool> interrupt_requested(false);
+static_assert(atomic<bool>::is_always_lock_free, "interrupt_requested is set from a signal handler");
+
+void request_interrupt(int signal_number) {
+    interrupt_requested.store(true, memory_order_relaxed);
+    signal(signal_number, SIG_DFL);
+}
+
+// Peak resident set size of the process in MiB.
+uint64_t peak_memory_mib() {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<uint64_t>(usage.ru_maxrss) / 1024;
+}
+
+// Compile-time configurations of the solver. Features a configuration leaves out are
+// compiled out of the search loop instead of being tested there on every decision and conflict.
+struct FullConfig {
+    static constexpr bool proof = true;  // proof logging through trace()
+    static constexpr bool stats = true;  // search counters, scoped timers, progress lines and SIGUSR1 dumps
+    using Restarts = RestartPolicy;      // chosen at run time by options.restart_mode
+};
+
+struct LeanConfig {
+    static constexpr bool proof = false;
+    static constexpr bool stats = false;  // conflicts, propagations and phase times are still kept
+    using Restarts = GlucoseRestarts;     // called directly rather than through the vtable
+};
+
+// Incremental CDCL solver. Clauses can be added between calls to solve, each of which may
+// assume some literals; learned clauses, activities, phases and restart state carry over
+// from one call to the next. Preprocessing runs on the first call only, with that call's
+// assumptions frozen; a later clause or assumption on an eliminated variable first brings
+// back every clause elimination removed.
+template <typename Config>
+class BasicSolver {
+public:
+    explicit BasicSolver(const SolverOptions& options = SolverOptions()) : BasicSolver(owned, options) {}
+
+    // Works on formula in place; it must outlive the solver.
+    BasicSolver(Formula& formula, const SolverOptions& options)
+        : formula(formula), options(options), assignments(formula.max_variable), watches(formula.max_variable),
+          order(formula.max_variable, options.var_decay), phases(formula.max_variable, options),
+          restarts(make_restarts(options)), db(options), rng(options.seed), conflicts(0),
+          initialized(false), consistent(true), stop(nullptr), interrupted(false), limit(nullptr), budget_polls(0),
+          exchange(nullptr), worker(0),
+          next_inprocess(options.inprocess_interval), inprocessings(0), inprocess_ticks(0), walk_ticks(0),
+          probe_cursor(0), stamp(0), proof(nullptr), created(chrono::steady_clock::now()), searching(false),
+          last_progress(created),
+          next_progress_check(0), seen_requests(stats_requests.load(memory_order_relaxed)) {}
+
+    BasicSolver(const BasicSolver&) = delete;
+    BasicSolver& operator=(const BasicSolver&) = delete;
+
+    // Makes the search poll stop before every decision, and share clauses through exchange as worker.
+    void join_portfolio(const atomic<bool>* stop_flag, ClauseExchange* bus, unsigned id) {
+        stop = stop_flag;
+        exchange = bus;
+        worker = id;
+    }
+
+    // Logs derived and deleted clauses to sink, which must be set before the first solve: the
+    // proof refutes the clauses added up to then. Techniques LRAT has no hints for are turned off.
+    void trace(Proof* sink) {
+        if (!Config::proof && sink) throw runtime_error("this solver configuration writes no proofs");
+        proof = sink;
+        db.proof = sink;
+        if (sink && sink->lrat()) options.preprocess = options.probe = options.inprocess = false;
+    }
+
+    // Forgets the formula, which is cleared too, and everything learned about it, as if newly
+    // built on it; the solver is also detached from its proof. The clause arena, the watch lists
+    // and the per-variable tables keep their allocations for the next formula.
+    void reset() {
+        formula.clear();
+        assignments.clear();
+        watches.clear();
+        order.clear();
+        phases.clear(options);
+        restarts = make_restarts(options);
+        db.clear();
+        db.proof = proof = nullptr;
+        rng.seed(options.seed);
+        conflicts = 0;
+        cursors.clear();
+        preprocessor.reset();
+        frozen.clear();
+        initialized = false;
+        consistent = true;
+        model.reset();
+        failed.clear();
+        interrupted.store(false, memory_order_relaxed);
+        limit = nullptr;
+        budget_polls = 0;
+        next_inprocess = options.inprocess_interval;
+        inprocessings = 0;
+        inprocess_ticks = walk_ticks = 0;
+        probe_cursor = 0;
+        fill(substitution.begin(), substitution.end(), Literal());
+        statistics = SolverStats();
+        created = last_progress = chrono::steady_clock::now();
+        next_progress_check = 0;
+    }
+
+    // Writes the simplified formula, the learned clauses and the heuristic state to path, for
+    // resume() to pick up. Call between solve calls, after the first.
+    void checkpoint(const string& path) {
+        if (!initialized) throw runtime_error("only a solver that has been solved can be checkpointed");
+        auto remaining = [&](uint64_t scheduled) { return scheduled > conflicts ? scheduled - conflicts : 0; };
+        SnapshotWriter out(path);
+        out.put<uint8_t>(consistent);
+        out.put<int32_t>(formula.max_variable);
+        out.put<uint64_t>(formula.variable_count);
+        out.put(formula.occurs);
+        out.put(formula.arena.memory);
+        out.put<uint64_t>(formula.arena.wasted);
+        out.put(formula.clauses);
+        out.put(assignments.trail);
+        out.put(assignments.saved_phases);
+        out.put(substitution);
+        out.put<uint8_t>(preprocessor != nullptr);
+        if (preprocessor) preprocessor->save(out);
+        out.put(db.core);
+        out.put(db.tier2);
+        out.put(db.local);
+        out.put(db.increment);
+        out.put<uint64_t>(db.reductions);
+        out.put<uint64_t>(remaining(db.next_reduce));
+        out.put(order.activity);
+        out.put(order.increment);
+        out.put(phases.target);
+        out.put<uint64_t>(phases.target_size);
+        out.put<uint64_t>(phases.rephase_count);
+        out.put<uint64_t>(remaining(phases.next_rephase));
+        out.put<uint64_t>(inprocessings);
+        out.put<uint64_t>(remaining(next_inprocess));
+        out.commit();
+    }
+
+    // Takes over the state checkpoint() wrote, in place of preprocessing, on a solver that has
+    // no clauses yet. The options of this solver apply from here on, and the counters of
+    // stats() start from zero; only the schedules of reductions, rephasing and inprocessing
+    // carry over.
+    void resume(const string& path) {
+        if (initialized || !formula.clauses.empty()) throw runtime_error("only a solver without clauses can resume");
+        if (proof) throw runtime_error("a resumed solver writes no proofs");
+        SnapshotReader in(path);
+        consistent = in.get<uint8_t>();
+        formula.max_variable = in.get<int32_t>();
+        if (formula.max_variable < 0) in.fail("is corrupt");
+        size_t variables = static_cast<size_t>(formula.max_variable) + 1;
+        formula.variable_count = in.get<uint64_t>();
+        in.get(formula.occurs);
+        in.get(formula.arena.memory);
+        formula.arena.wasted = in.get<uint64_t>();
+        in.get(formula.clauses);
+        vector<Literal> fixed;
+        in.get(fixed);
+        grow();
+        in.get(assignments.saved_phases, variables);
+        in.get(substitution, variables);
+        if (in.get<uint8_t>()) {
+            preprocessor = make_unique<Preprocessor>(formula, options, proof);
+            preprocessor->load(in);
+        }
+        in.get(db.core);
+        in.get(db.tier2);
+        in.get(db.local);
+        db.increment = in.get<float>();
+        db.reductions = in.get<uint64_t>();
+        db.next_reduce = conflicts + in.get<uint64_t>();
+        in.get(order.activity, variables);
+        order.increment = in.get<double>();
+        in.get(phases.target, variables);
+        phases.target_size = in.get<uint64_t>();
+        phases.rephase_count = in.get<uint64_t>();
+        phases.next_rephase = conflicts + in.get<uint64_t>();
+        inprocessings = in.get<uint64_t>();
+        next_inprocess = conflicts + in.get<uint64_t>();
+        in.finish();
+
+        // Every clause and literal is checked to lie inside the arena and the variable tables
+        // before anything is indexed by them.
+        auto in_range = [&](const Literal& lit) {
+            return lit.variable() >= 1 && lit.variable() <= formula.max_variable;
+        };
+        for (const Literal& lit : fixed) {
+            if (!in_range(lit)) in.fail("is corrupt");
+        }
+        for (size_t var = 1; var < substitution.size(); ++var) {
+            if (substitution[var] != Literal() && !in_range(substitution[var])) in.fail("is corrupt");
+        }
+        const ClauseArena& arena = formula.arena;
+        for (const vector<ClauseRef>* refs : {&formula.clauses, &db.core, &db.tier2, &db.local}) {
+            for (ClauseRef ref : *refs) {
+                if (ref > arena.size() || arena.size() - ref < ClauseArena::HEADER_WORDS ||
+                    arena[ref].size() > arena.size() - ref - ClauseArena::HEADER_WORDS) {
+                    in.fail("is corrupt");
+                }
+                for (const Literal& lit : arena[ref]) {
+                    if (!in_range(lit)) in.fail("is corrupt");
+                }
+            }
+        }
+
+        // Watches, the heap and the level-0 trail are rebuilt; propagating the trail again
+        // restores the watch invariants whatever order the lists come back in.
+        initialized = true;
+        for (const Literal& lit : fixed) {
+            int var = lit.variable();
+            if (!assignments.is_assigned(var)) assignments.assign(var, !lit.negation(), NO_REASON);
+        }
+        for (int var = 1; var <= formula.max_variable; ++var) {
+            if (!assignments.is_assigned(var) && substitution[var] == Literal() &&
+                !(preprocessor && preprocessor->is_eliminated(var))) {
+                order.insert(var);
+            }
+        }
+        // Sizing every watch list first saves growing millions of them one watcher at a time.
+        size_t literals = watches.lists.size();
+        vector<uint32_t> counts(2 * literals, 0);
+        for (const vector<ClauseRef>* refs : {&formula.clauses, &db.core, &db.tier2, &db.local}) {
+            for (ClauseRef ref : *refs) {
+                const Clause& clause = formula.clause(ref);
+                if (clause.removed || clause.size() < 2) continue;
+                size_t offset = clause.size() == 2 ? literals : 0;
+                ++counts[offset + clause[0].index()];
+                ++counts[offset + clause[1].index()];
+            }
+        }
+        for (size_t i = 0; i < literals; ++i) {
+            watches.lists[i].reserve(counts[i]);
+            watches.binaries[i].reserve(counts[literals + i]);
+        }
+        for (const vector<ClauseRef>* refs : {&formula.clauses, &db.core, &db.tier2, &db.local}) {
+            for (ClauseRef ref : *refs) {
+                const Clause& clause = formula.clause(ref);
+                if (!clause.removed && clause.size() >= 2) watches.attach(formula, ref);
+            }
+        }
+        if (consistent && unit_propagation(formula, assignments, watches).first == "conflict") consistent = false;
+    }
+
+    // Keeps var out of variable elimination; only has an effect before the first solve.
+    void freeze(int var) {
+        frozen.push_back(var);
+    }
+
+    void add_clause(const vector<Literal>& lits) {
+        if (!initialized) {
+            formula.add_clause(lits);
+            return;
+        }
+        for (const Literal& lit : lits) ensure_variable(lit.variable());
+        if (!consistent) return;
+        backtrack(assignments, 0, order);
+
+        vector<Literal> kept(lits);
+        if (!simplify(kept)) return;
+        if (kept.empty()) {
+            consistent = false;
+            return;
+        }
+        ClauseRef ref = formula.add_clause(kept);
+        if (kept.size() == 1) {
+            assignments.assign(kept[0].variable(), !kept[0].negation(), ref);
+            if (unit_propagation(formula, assignments, watches).first == "conflict") consistent = false;
+        } else {
+            watches.attach(formula, ref);
+        }
+    }
+
+    // Decides the formula under assumptions. UNSATISFIABLE with a non-empty failed_assumptions()
+    // means the assumptions, not the formula, are to blame. The search gives up with UNKNOWN
+    // once this call has used up options.max_conflicts, time_limit or mem_limit (0 means no
+    // limit), after an interrupt, or once stop is raised; stats().limit then names the budget.
+    SolveStatus solve(const vector<Literal>& assumptions = {}) {
+        model.reset();
+        failed.clear();
+        limit = nullptr;
+        for (const Literal& lit : assumptions) ensure_variable(lit.variable());
+        auto start = chrono::steady_clock::now();
+        deadline = start + chrono::duration_cast<chrono::steady_clock::duration>(
+                               chrono::duration<double>(options.time_limit));
+        if (consistent && !initialized) {
+            initialize(assumptions);
+            if (!options.snapshot_file.empty()) checkpoint(options.snapshot_file);
+        }
+        statistics.simplify_seconds += seconds_since(start);
+        if (!consistent) return SolveStatus::UNSATISFIABLE;
+
+        vector<Literal> substituted;
+        for (const Literal& lit : assumptions) substituted.push_back(representative(lit));
+        search_start = chrono::steady_clock::now();
+        searching = true;
+        SolveStatus status = search(substituted);
+        searching = false;
+        statistics.search_seconds += seconds_since(search_start);
+        if (status == SolveStatus::SATISFIABLE) {
+            model = assignments;
+            for (size_t var = 1; var < substitution.size(); ++var) {
+                if (substitution[var] != Literal()) model->values[var] = model->value(substitution[var]) ? 1 : 0;
+            }
+            if (preprocessor) preprocessor->extend_model(*model);
+        }
+        if (!failed.empty()) {
+            // Report the caller's literals, not their substitutes.
+            sort(failed.begin(), failed.end(), [](const Literal& a, const Literal& b) { return a.code < b.code; });
+            vector<Literal> blamed;
+            for (size_t i = 0; i < assumptions.size(); ++i) {
+                if (binary_search(failed.begin(), failed.end(), substituted[i],
+                                  [](const Literal& a, const Literal& b) { return a.code < b.code; })) {
+                    blamed.push_back(assumptions[i]);
+                }
+            }
+            failed.swap(blamed);
+        }
+        if (consistent) backtrack(assignments, 0, order);
+        if (status == SolveStatus::UNKNOWN && !options.snapshot_file.empty()) checkpoint(options.snapshot_file);
+        return status;
+    }
+
+    // Makes the running solve call, or else the next one, give up with UNKNOWN at its next
+    // decision. Safe to call from any thread and from signal handlers.
+    void interrupt() {
+        interrupted.store(true, memory_order_relaxed);
+    }
+
+    // Value of lit in the model found by the last solve; false if there is none.
+    bool value(const Literal& lit) const {
+        return model && model->value(lit);
+    }
+
+    // After an UNSATISFIABLE answer under assumptions: a subset of them that cannot hold together.
+    const vector<Literal>& failed_assumptions() const {
+        return failed;
+    }
+
+    optional<Assignments> take_model() {
+        optional<Assignments> taken;
+        taken.swap(model);
+        return taken;
+    }
+
+    SolverStats stats() const {
+        SolverStats stats = statistics;
+        stats.conflicts = conflicts;
+        stats.propagations = watches.propagations;
+        stats.deleted = db.deleted;
+        if (searching) stats.search_seconds += seconds_since(search_start);
+        stats.limit = limit;
+        return stats;
+    }
+
+private:
+    Formula owned;  // clauses of a solver built without a formula; declared first so formula can bind to it
+    Formula& formula;
+    SolverOptions options;
+    Assignments assignments;
+    Watches watches;
+    VarOrder order;
+    Phases phases;
+    unique_ptr<typename Config::Restarts> restarts;
+    ClauseDatabase db;
+    mt19937 rng;
+    uint64_t conflicts;
+    vector<uint64_t> cursors;
+    unique_ptr<Preprocessor> preprocessor;  // kept after the first solve to extend models
+    vector<int> frozen;
+    bool initialized;  // clauses attached and level 0 propagated
+    bool consistent;   // false once the formula itself is known to be unsatisfiable
+    optional<Assignments> model;
+    vector<Literal> failed;
+    const atomic<bool>* stop;
+    atomic<bool> interrupted;
+    const char* limit;              // the budget the last solve call ran out of
+    chrono::steady_clock::time_point deadline;
+    uint32_t budget_polls;
+    ClauseExchange* exchange;
+    unsigned worker;
+    uint64_t next_inprocess;
+    uint64_t inprocessings;
+    uint64_t inprocess_ticks;       // propagation ticks at the end of the previous round
+    uint64_t walk_ticks;            // and at the end of the previous walk
+    uint32_t probe_cursor;
+    vector<Literal> substitution;   // variable -> literal equivalent to it, or Literal() if it stands for itself
+    vector<uint32_t> marks;         // per-literal scratch stamps
+    uint32_t stamp;
+    AnalysisScratch analysis;
+    Proof* proof;
+    SolverStats statistics;  // counters kept here; conflicts, propagations and deletions live with their users
+    chrono::steady_clock::time_point created;
+    chrono::steady_clock::time_point search_start;
+    bool searching;
+    chrono::steady_clock::time_point last_progress;
+    uint64_t next_progress_check;  // conflict count at which to look at the clock again
+    unsigned seen_requests;        // value of stats_requests when the statistics were last printed
+
+    static unique_ptr<typename Config::Restarts> make_restarts(const SolverOptions& options) {
+        if constexpr (is_same_v<typename Config::Restarts, RestartPolicy>) {
+            return make_restart_policy(options);
+        } else {
+            return make_unique<typename Config::Restarts>();
+        }
+    }
+
+    // Adds by to a search counter, if the configuration keeps them.
+    static void count(uint64_t& counter, uint64_t by = 1) {
+        if constexpr (Config::stats) counter += by;
+    }
+
+    // The slot a scoped timer adds to, or none unless timers are on.
+    double* timer(double& slot) {
+        return Config::stats && options.timers ? &slot : nullptr;
+    }
+
+    template <typename Work>
+    auto timed(double& slot, Work&& work) {
+        if constexpr (Config::stats) {
+            ScopedTimer timing(timer(slot));
+            return work();
+        } else {
+            return work();
+        }
+    }
+
+    // Prints a progress line every options.progress seconds, and the statistics as JSON after a
+    // SIGUSR1. Polled between decisions; the clock is read once every 256 conflicts at most.
+    void report() {
+        unsigned requests = stats_requests.load(memory_order_relaxed);
+        if (requests != seen_requests) {
+            seen_requests = requests;
+            string line = "c stats " + worker_label() + stats().to_json() + "\n";
+            fputs(line.c_str(), stderr);
+        }
+        if (options.progress <= 0 || conflicts < next_progress_check) return;
+        next_progress_check = conflicts + 256;
+        if (seconds_since(last_progress) < options.progress) return;
+        last_progress = chrono::steady_clock::now();
+        SolverStats now = stats();
+        double elapsed = seconds_since(created);
+        char line[256];
+        snprintf(line, sizeof(line),
+                 "c %s%.1fs conflicts %llu decisions %llu props/s %.0f restarts %llu learned %llu deleted %llu"
+                 " lbd %.2f trail %.1f fixed %zu\n",
+                 worker_label().c_str(), elapsed, static_cast<unsigned long long>(now.conflicts),
+                 static_cast<unsigned long long>(now.decisions), elapsed > 0 ? now.propagations / elapsed : 0.0,
+                 static_cast<unsigned long long>(now.restarts), static_cast<unsigned long long>(now.learned),
+                 static_cast<unsigned long long>(now.deleted), now.average_lbd(), now.average_trail(),
+                 assignments.decision_level() > 0 ? assignments.trail_lim[0] : assignments.trail.size());
+        fputs(line, stderr);
+    }
+
+    // Names the budget this solve call has run out of, or returns nullptr. Interrupts are seen at
+    // once, and an interrupt() is used up by the call it stops; the clock and the memory use are
+    // only looked at every 256 decisions.
+    const char* exhausted(uint64_t conflict_limit) {
+        if ((interrupted.load(memory_order_relaxed) && interrupted.exchange(false, memory_order_relaxed)) ||
+            interrupt_requested.load(memory_order_relaxed)) {
+            return "interrupt";
+        }
+        if (conflict_limit && conflicts >= conflict_limit) return "conflict limit";
+        if (++budget_polls % 256 != 0 || (options.time_limit <= 0 && !options.mem_limit)) return nullptr;
+        if (options.time_limit > 0 && chrono::steady_clock::now() >= deadline) return "time limit";
+        if (options.mem_limit && peak_memory_mib() >= options.mem_limit) return "memory limit";
+        return nullptr;
+    }
+
+    // Backtracks to the highest level among the literals of conflict, which out-of-order
+    // assignments can leave below the current level. Returns false if only one literal has that
+    // level: the clause missed an implication, which is now made after backtracking further,
+    // and leaves nothing to analyze.
+    bool settle_conflict(ClauseRef conflict) {
+        Clause& clause = formula.clause(conflict);
+        int top = 0, second = 0, count = 0;
+        size_t forced = 0;
+        for (size_t i = 0; i < clause.size(); ++i) {
+            int level = assignments.level(clause[i].variable());
+            if (level > top) {
+                second = top;
+                top = level;
+                count = 1;
+                forced = i;
+            } else if (level == top) {
+                ++count;
+            } else if (level > second) {
+                second = level;
+            }
+        }
+        if (count > 1 || top == 0) {
+            backtrack(assignments, top, order);
+            return true;
+        }
+        backtrack(assignments, options.chrono && second > 0 ? top - 1 : second, order);
+        // Watch the implied literal and one of the next highest level, as for a learned clause.
+        bool watched = clause.size() > 2;
+        if (watched) watches.detach(formula, conflict);
+        swap(clause[0], clause[forced]);
+        for (size_t i = 2; i < clause.size(); ++i) {
+            if (assignments.level(clause[i].variable()) > assignments.level(clause[1].variable())) swap(clause[1], clause[i]);
+        }
+        if (watched) watches.attach(formula, conflict);
+        assignments.assign(clause[0].variable(), !clause[0].negation(), conflict, second);
+        return false;
+    }
+
+    string worker_label() const {
+        return stop ? "worker " + to_string(worker) + " " : "";
+    }
+
+    void grow() {
+        assignments.resize(formula.max_variable);
+        watches.resize(formula.max_variable);
+        order.resize(formula.max_variable);
+        phases.resize(formula.max_variable);
+        substitution.resize(formula.max_variable + 1, Literal());
+        marks.resize(2 * static_cast<size_t>(formula.max_variable) + 2, 0);
+    }
+
+    void ensure_variable(int var) {
+        formula.note_variable(var);
+        if (!initialized) return;
+        grow();
+        if (preprocessor && preprocessor->is_eliminated(var)) restore_eliminated();
+        if (!assignments.is_assigned(var) && substitution[var] == Literal()) order.insert(var);
+    }
+
+    Literal representative(const Literal& lit) const {
+        size_t var = lit.variable();
+        if (var >= substitution.size() || substitution[var] == Literal()) return lit;
+        return lit.negation() ? substitution[var].neg() : substitution[var];
+    }
+
+    // Rewrites lits by the substitution and the level-0 assignment, dropping false and duplicate
+    // literals; returns false if the clause is satisfied or tautological.
+    bool simplify(vector<Literal>& lits) {
+        uint32_t current = ++stamp;
+        size_t size = 0;
+        for (const Literal& original : lits) {
+            Literal lit = representative(original);
+            if (assignments.value(lit) || marks[lit.neg().index()] == current) return false;
+            if (assignments.falsified(lit) || marks[lit.index()] == current) continue;
+            marks[lit.index()] = current;
+            lits[size++] = lit;
+        }
+        lits.resize(size);
+        return true;
+    }
+
+    // Adds the clauses peers published since the last import. A clause learned by one worker
+    // is implied by the formula of every other: they all preprocess the same input identically,
+    // and inprocessing only adds implied clauses and equivalences. Must be called at level 0;
+    // returns false if the imported clauses make the formula unsatisfiable.
+    bool import_shared() {
+        bool ok = true;
+        vector<Literal> kept;
+        exchange->collect(worker, cursors, [&](const vector<Literal>& lits, unsigned lbd) {
+            kept = lits;
+            if (!ok || !simplify(kept)) return;
+            if (kept.empty()) {
+                ok = false;
+            } else if (kept.size() == 1) {
+                ClauseRef ref = db.learn(formula, kept, 1);
+                assignments.assign(kept[0].variable(), !kept[0].negation(), ref);
+            } else {
+                ClauseRef ref = db.learn(formula, kept, min<unsigned>(lbd, kept.size()));
+                watches.attach(formula, ref);
+            }
+        });
+        return ok && unit_propagation(formula, assignments, watches).first != "conflict";
+    }
+
+    void restore_eliminated() {
+        vector<int> restored;
+        vector<vector<Literal>> clauses = preprocessor->restore(restored);
+        for (int var : restored) order.insert(var);
+        for (const vector<Literal>& clause : clauses) add_clause(clause);
+    }
+
+    void initialize(const vector<Literal>& assumptions) {
+        initialized = true;
+        grow();
+        if (proof && proof->lrat()) {
+            for (ClauseRef ref : formula.clauses) proof->original(ref);
+        }
+        if (options.preprocess) {
+            preprocessor = make_unique<Preprocessor>(formula, options, proof);
+            for (int var : frozen) preprocessor->freeze(var);
+            for (const Literal& lit : assumptions) preprocessor->freeze(lit.variable());
+            ScopedTimer preprocessing(timer(statistics.preprocess_seconds));
+            if (!preprocessor->run()) {
+                refute();
+                return;
+            }
+        }
+        for (int var : formula.get_variables()) {
+            if (!preprocessor || !preprocessor->is_eliminated(var)) order.insert(var);
+        }
+
+        for (ClauseRef ref : formula.clauses) {
+            const Clause& input = formula.clause(ref);
+            if (input.size() == 0) {
+                refute(ref);
+                return;
+            }
+            if (input.size() == 1) {
+                const Literal& unit = input[0];
+                if (assignments.falsified(unit)) {
+                    refute(ref);
+                    return;
+                }
+                if (!assignments.is_assigned(unit.variable())) assignments.assign(unit.variable(), !unit.negation(), ref);
+                continue;
+            }
+            watches.attach(formula, ref);
+        }
+
+        auto [status, conflict] = unit_propagation(formula, assignments, watches);
+        if (status == "conflict") {
+            refute(*conflict);
+        } else if (options.probe &&
+                   !probe_failed_literals(formula, assignments, watches, options.probe_steps, probe_cursor, proof)) {
+            refute();
+        }
+    }
+
+    // Marks the formula unsatisfiable, ending the proof with the empty clause; conflict is a
+    // clause falsified at level 0, if known.
+    void refute(ClauseRef conflict = NO_REASON) {
+        consistent = false;
+        if (proof) proof->conclude(formula, assignments, conflict);
+    }
+
+    // One inprocessing round at level 0, with budgets proportional to the propagation work done
+    // since the previous round. Returns false if the formula turned out unsatisfiable.
+    bool inprocess() {
+        ScopedTimer inprocessing(timer(statistics.inprocess_seconds));
+        ++inprocessings;
+        next_inprocess = conflicts + options.inprocess_interval * (inprocessings + 1);
+        double budget = static_cast<double>(watches.ticks - inprocess_ticks);
+        // Level-0 reasons are never analyzed; dropping them frees the clauses for rewriting.
+        for (const Literal& lit : assignments.trail) assignments.reasons[lit.variable()] = NO_REASON;
+        bool ok = probe_failed_literals(formula, assignments, watches, static_cast<uint64_t>(budget * options.probe_effort),
+                                        probe_cursor, proof) &&
+                  substitute_equivalent_literals(static_cast<uint64_t>(budget * options.substitute_effort)) &&
+                  vivify(static_cast<uint64_t>(budget * options.vivify_effort));
+        inprocess_ticks = watches.ticks;
+        return ok;
+    }
+
+    // Local search from the saved phases, with a budget proportional to the propagation work
+    // since the previous walk. Its best assignment becomes the target phases. Returns true if
+    // it satisfied every irredundant clause: the model is then assigned, on one decision level.
+    bool walk() {
+        ScopedTimer walking(timer(statistics.walk_seconds));
+        LocalSearch local(formula, assignments, assignments.saved_phases);
+        double budget = static_cast<double>(watches.ticks - walk_ticks) * options.walk_effort;
+        bool found = local.run(static_cast<uint64_t>(budget), rng);
+        walk_ticks = watches.ticks;
+        count(statistics.walks);
+        count(statistics.flips, local.flips);
+        for (size_t var = 1; var < local.best.size(); ++var) {
+            if (!local.fixed[var]) phases.target[var] = local.best[var];
+        }
+        if (!found) return false;
+        backtrack(assignments, 0, order);
+        assignments.new_decision_level();
+        for (int var = 1; var <= formula.max_variable; ++var) {
+            if (assignments.is_assigned(var) || substitution[var] != Literal() ||
+                (preprocessor && preprocessor->is_eliminated(var))) {
+                continue;
+            }
+            assignments.assign(var, local.values[var], NO_REASON);
+        }
+        return true;
+    }
+
+    // Equivalent-literal substitution: literals in one strongly connected component of the
+    // binary implication graph are equivalent, so each is replaced by the component's literal
+    // on the lowest variable. Tarjan's algorithm, iterative; a component holding both x and ~x
+    // means the formula is unsatisfiable. Skipped when one pass over the graph exceeds budget.
+    bool substitute_equivalent_literals(uint64_t budget) {
+        uint32_t literal_count = static_cast<uint32_t>(watches.binaries.size());
+        uint64_t edges = 0;
+        for (const vector<Watcher>& ws : watches.binaries) edges += ws.size();
+        if (edges == 0 || edges > budget) return true;
+
+        vector<int> index(literal_count, -1), low(literal_count, 0), component(literal_count, -1);
+        vector<uint32_t> stack;
+        vector<pair<uint32_t, size_t>> frames;  // node and its next outgoing edge
+        vector<int> substituted;
+        int counter = 0, components = 0;
+        for (uint32_t root = 2; root < literal_count; ++root) {
+            Literal start;
+            start.code = root;
+            if (index[root] >= 0 || assignments.is_assigned(start.variable())) continue;
+            index[root] = low[root] = counter++;
+            stack.push_back(root);
+            frames.emplace_back(root, 0);
+            while (!frames.empty()) {
+                uint32_t node = frames.back().first;
+                Literal lit;
+                lit.code = node;
+                // lit implies the other literal of every binary clause containing ~lit.
+                const vector<Watcher>& successors = watches.binaries[lit.neg().index()];
+                if (frames.back().second < successors.size()) {
+                    Literal next = successors[frames.back().second++].blocker;
+                    if (assignments.is_assigned(next.variable())) continue;
+                    uint32_t w = next.index();
+                    if (index[w] < 0) {
+                        index[w] = low[w] = counter++;
+                        stack.push_back(w);
+                        frames.emplace_back(w, 0);
+                    } else if (component[w] < 0) {
+                        low[node] = min(low[node], index[w]);
+                    }
+                    continue;
+                }
+                frames.pop_back();
+                if (!frames.empty()) low[frames.back().first] = min(low[frames.back().first], low[node]);
+                if (low[node] != index[node]) continue;
+
+                size_t first = stack.size();
+                do {
+                    --first;
+                    component[stack[first]] = components;
+                } while (stack[first] != node);
+                Literal best;
+                for (size_t i = first; i < stack.size(); ++i) {
+                    Literal member;
+                    member.code = stack[i];
+                    if (component[member.neg().index()] == components) {
+                        // member implies its own negation through binaries, and so does ~member.
+                        if (proof) proof->add(array<Literal, 1>{member.neg()});
+                        return false;
+                    }
+                    if (best == Literal() || member.variable() < best.variable()) best = member;
+                }
+                for (size_t i = first; i < stack.size() && stack.size() - first > 1; ++i) {
+                    Literal member;
+                    member.code = stack[i];
+                    int var = member.variable();
+                    if (member == best || substitution[var] != Literal()) continue;
+                    substitution[var] = member.negation() ? best.neg() : best;
+                    substituted.push_back(var);
+                }
+                stack.resize(first);
+                ++components;
+            }
+        }
+        if (substituted.empty()) return true;
+
+        // Earlier substitutes may just have been substituted themselves.
+        for (size_t var = 1; var < substitution.size(); ++var) {
+            while (substitution[var] != Literal() && substitution[substitution[var].variable()] != Literal()) {
+                substitution[var] = representative(substitution[var]);
+            }
+        }
+        for (int var : substituted) order.remove(var);
+        return rewrite_clauses(true);
+    }
+
+    // Vivification of learned clauses: assigns the negation of a clause's literals one at a time
+    // and propagates. A conflict, or a later literal turning true, shows a prefix already implies
+    // the clause; a later literal turning false can be dropped. Each clause is tried once,
+    // lowest LBD first, until budget propagation ticks are spent.
+    bool vivify(uint64_t budget) {
+        vector<ClauseRef> candidates;
+        for (vector<ClauseRef>* tier : {&db.core, &db.tier2}) {
+            for (ClauseRef ref : *tier) {
+                const Clause& clause = formula.clause(ref);
+                if (!clause.removed && !clause.vivified && clause.size() > 2) candidates.push_back(ref);
+            }
+        }
+        sort(candidates.begin(), candidates.end(), [&](ClauseRef a, ClauseRef b) {
+            const Clause& x = formula.clause(a);
+            const Clause& y = formula.clause(b);
+            return x.lbd != y.lbd ? x.lbd < y.lbd : x.size() < y.size();
+        });
+
+        // Probing assignments must not count as search for phase saving.
+        vector<int8_t> saved_phases = assignments.saved_phases;
+        uint64_t start = watches.ticks;
+        vector<pair<ClauseRef, vector<Literal>>> strengthened;
+        vector<Literal> lits, kept;
+        for (ClauseRef ref : candidates) {
+            if (watches.ticks - start >= budget) break;
+            Clause& clause = formula.clause(ref);
+            clause.vivified = 1;
+            lits.assign(clause.begin(), clause.end());
+            kept.clear();
+            assignments.new_decision_level();
+            for (const Literal& lit : lits) {
+                if (assignments.value(lit)) {
+                    kept.push_back(lit);
+                    break;
+                }
+                if (assignments.falsified(lit)) continue;
+                kept.push_back(lit);
+                assignments.assign(lit.variable(), lit.negation(), NO_REASON);
+                if (unit_propagation(formula, assignments, watches).first == "conflict") break;
+            }
+            backtrack(assignments, 0, order);
+            if (kept.size() < lits.size()) strengthened.emplace_back(ref, kept);
+        }
+        assignments.saved_phases.swap(saved_phases);
+        if (strengthened.empty()) return true;
+
+        for (const auto& [ref, shorter] : strengthened) {
+            Clause& clause = formula.clause(ref);
+            if (proof) {
+                proof->add(shorter);
+                proof->remove(clause);
+            }
+            copy(shorter.begin(), shorter.end(), clause.begin());
+            formula.arena.shrink(ref, shorter.size());
+        }
+        return rewrite_clauses(false);
+    }
+
+    // At level 0: applies the substitution and drops false and duplicate literals in every
+    // clause, deleting satisfied and tautological ones, then watches all clauses afresh.
+    // Returns false on an empty clause or conflicting units. Unless substituted says the
+    // substitution just grew, a clause without level-0 literals is kept as it is; one scan
+    // of its values tells.
+    bool rewrite_clauses(bool substituted) {
+        for (vector<Watcher>& ws : watches.lists) ws.clear();
+        for (vector<Watcher>& ws : watches.binaries) ws.clear();
+        vector<Literal> units;
+        bool ok = true;
+        vector<Literal> lits;
+        if (proof) {
+            // Log every rewritten clause before deleting any: the binary clauses behind a
+            // substitution are themselves rewritten into tautologies.
+            proof->log_units(formula, assignments);
+            auto log = [&](ClauseRef ref) {
+                const Clause& clause = formula.clause(ref);
+                LiteralScan scan = scan_literals(clause.begin(), clause.size(), assignments.values.data());
+                if (scan.satisfied || (!substituted && scan.falsified == 0)) return;
+                lits.assign(clause.begin(), clause.end());
+                if (simplify(lits) && !equal(lits.begin(), lits.end(), clause.begin(), clause.end())) proof->add(lits);
+            };
+            for (ClauseRef ref : formula.clauses) log(ref);
+            for (vector<ClauseRef>* tier : {&db.core, &db.tier2, &db.local}) {
+                for (ClauseRef ref : *tier) log(ref);
+            }
+        }
+        auto rewrite = [&](ClauseRef ref) {
+            Clause& clause = formula.clause(ref);
+            LiteralScan scan = scan_literals(clause.begin(), clause.size(), assignments.values.data());
+            bool drop = scan.satisfied;
+            if (!drop && (substituted || scan.falsified > 0)) {
+                lits.assign(clause.begin(), clause.end());
+                drop = !simplify(lits);
+                if (!drop) {
+                    if (proof && !equal(lits.begin(), lits.end(), clause.begin(), clause.end())) proof->remove(clause);
+                    copy(lits.begin(), lits.end(), clause.begin());
+                    formula.arena.shrink(ref, lits.size());
+                }
+            }
+            if (drop) {
+                if (proof) proof->remove(clause);
+                formula.arena.free(ref);
+                return false;
+            }
+            if (clause.size() == 0) {
+                ok = false;
+            } else if (clause.size() == 1) {
+                units.push_back(clause[0]);
+            } else {
+                watches.attach(formula, ref);
+            }
+            return true;
+        };
+        formula.clauses.erase(remove_if(formula.clauses.begin(), formula.clauses.end(),
+                                        [&](ClauseRef ref) { return !rewrite(ref); }),
+                              formula.clauses.end());
+        for (vector<ClauseRef>* tier : {&db.core, &db.tier2, &db.local}) {
+            for (ClauseRef ref : *tier) rewrite(ref);
+        }
+        db.purge(formula);
+        if (!ok) return false;
+
+        for (const Literal& unit : units) {
+            if (assignments.falsified(unit)) return false;
+            if (!assignments.is_assigned(unit.variable())) assignments.assign(unit.variable(), !unit.negation(), NO_REASON);
+        }
+        return unit_propagation(formula, assignments, watches).first != "conflict";
+    }
+
+    // Collects into failed the assumptions whose implications falsified the assumption lit,
+    // walking the trail back through reasons; every decision it reaches is an assumption.
+    void analyze_final(const Literal& lit) {
+        failed.assign(1, lit);
+        if (assignments.level(lit.variable()) == 0) return;
+        vector<uint8_t> seen(assignments.values.size(), 0);
+        seen[lit.variable()] = 1;
+        for (size_t i = assignments.trail.size(); i-- > assignments.trail_lim[0];) {
+            int var = assignments.trail[i].variable();
+            if (!seen[var]) continue;
+            ClauseRef reason = assignments.reason(var);
+            if (reason == NO_REASON) {
+                failed.push_back(assignments.trail[i]);
+            } else {
+                for (const Literal& q : formula.clause(reason)) {
+                    if (q.variable() != var && assignments.level(q.variable()) > 0) seen[q.variable()] = 1;
+                }
+            }
+        }
+    }
+
+    SolveStatus search(vector<Literal>& assumptions) {
+        uint64_t conflict_limit = options.max_conflicts ? conflicts + options.max_conflicts : 0;
+        while (true) {
+            if (restarts->should_restart()) {
+                phases.update_target(assignments, assignments.trail.size());
+                backtrack(assignments, 0, order);
+                restarts->on_restart();
+                count(statistics.restarts);
+                if ((exchange && !import_shared()) ||
+                    (options.inprocess && conflicts >= next_inprocess && !inprocess())) {
+                    refute();
+                    return SolveStatus::UNSATISFIABLE;
+                }
+                // Inprocessing may have substituted assumed variables.
+                for (Literal& lit : assumptions) lit = representative(lit);
+            }
+            if (stop && stop->load(memory_order_relaxed)) return SolveStatus::UNKNOWN;
+            if ((limit = exhausted(conflict_limit))) return SolveStatus::UNKNOWN;
+            if constexpr (Config::stats) report();
+            if (phases.maybe_rephase(assignments, conflicts, options, rng) && options.walk && assumptions.empty() &&
+                walk()) {
+                return SolveStatus::SATISFIABLE;
+            }
+
+            // Assumptions come first; one already true still gets its own (empty) level.
+            Literal decision;
+            while (assignments.decision_level() < static_cast<int>(assumptions.size())) {
+                const Literal& assumption = assumptions[assignments.decision_level()];
+                if (assignments.falsified(assumption)) {
+                    analyze_final(assumption);
+                    return SolveStatus::UNSATISFIABLE;
+                }
+                if (!assignments.value(assumption)) {
+                    decision = assumption;
+                    break;
+                }
+                assignments.new_decision_level();
+            }
+            if (decision == Literal()) {
+                auto [var, val] = pick_branching_variable(order, assignments, phases, options, rng);
+                if (var == 0) return SolveStatus::SATISFIABLE;
+                decision = Literal(var, !val);
+            }
+            count(statistics.decisions);
+            assignments.new_decision_level();
+            assignments.assign(decision.variable(), !decision.negation(), NO_REASON);
+
+            while (true) {
+                auto [reason, clause] = timed(statistics.propagate_seconds,
+                                              [&] { return unit_propagation(formula, assignments, watches); });
+                if (reason != "conflict") break;
+                ++conflicts;
+                count(statistics.trail_sum, assignments.trail.size());
+                if (!settle_conflict(clause.value())) continue;
+
+                int b = timed(statistics.analyze_seconds, [&] {
+                    int level = conflict_analysis(formula, clause.value(), assignments, order, db, options, analysis);
+                    if (Config::proof && proof && level >= 0) proof->chain(formula, assignments, clause.value(), analysis.learned);
+                    return level;
+                });
+                vector<Literal>& learned_clause = analysis.learned;
+                if (b < 0) {
+                    refute(clause.value());
+                    return SolveStatus::UNSATISFIABLE;
+                }
+                order.decay_activities();
+                db.decay_activities();
+                unsigned lbd = db.compute_lbd(learned_clause, assignments);
+                restarts->on_conflict(lbd, assignments.trail.size());
+                count(statistics.learned);
+                count(statistics.lbd_sum, lbd);
+
+                // Everything below the conflict level was assigned without conflict.
+                phases.update_target(assignments, assignments.trail_lim[assignments.decision_level() - 1]);
+                // A long backjump throws away assignments that would mostly be made again, so it
+                // only goes back one level and assigns the UIP out of order. Units still go to level 0.
+                int jump = assignments.decision_level() - b;
+                backtrack(assignments, b > 0 && options.chrono && jump > static_cast<int>(options.chrono)
+                                           ? assignments.decision_level() - 1 : b, order);
+
+                // The learned clause is asserting: after backjumping it is unit on the UIP.
+                order_watches(learned_clause, assignments);
+                ClauseRef ref = db.learn(formula, learned_clause, lbd);
+                if (Config::proof && proof) proof->add(learned_clause, ref);
+                if (exchange && learned_clause.size() <= min(options.share_size, ClauseExchange::MAX_SIZE) &&
+                    lbd <= options.share_lbd) {
+                    exchange->publish(worker, learned_clause, lbd);
+                }
+                const Literal& first = learned_clause[0];
+                if (learned_clause.size() == 1 || assignments.falsified(learned_clause[1])) {
+                    if (!assignments.is_assigned(first.variable())) {
+                        assignments.assign(first.variable(), !first.negation(), ref, b);
+                    }
+                }
+                if (learned_clause.size() > 1) watches.attach(formula, ref);
+
+                if (db.should_reduce(conflicts)) {
+                    ScopedTimer reducing(timer(statistics.reduce_seconds));
+                    db.reduce(formula, assignments, watches, conflicts);
+                }
+            }
+        }
+    }
+};
+
+using Solver = BasicSolver<FullConfig>;
+
+// One-shot solve of formula in place, see Solver.
+template <typename Config = FullConfig>
+SolveResult cdcl_solve(Formula& formula, const SolverOptions& options = SolverOptions(),
+                       const vector<Literal>& assumptions = {}, const atomic<bool>* stop = nullptr,
+                       ClauseExchange* exchange = nullptr, unsigned worker = 0, Proof* proof = nullptr) {
+    BasicSolver<Config> solver(formula, options);
+    solver.join_portfolio(stop, exchange, worker);
+    solver.trace(proof);
+    if (!options.resume_file.empty()) solver.resume(options.resume_file);
+    SolveStatus status = solver.solve(assumptions);
+    return {status, solver.take_model(), {solver.stats()}};
+}
+
+// One-shot solve with the compiled configuration options.engine selects.
+SolveResult engine_solve(Formula& formula, const SolverOptions& options) {
+    if (options.engine == Engine::LEAN) return cdcl_solve<LeanConfig>(formula, options);
+    return cdcl_solve(formula, options);
+}
+
+// Configuration of portfolio worker i: worker 0 runs the options as given, the others get
+// their own seed and cycle through restart policies, phase modes and decay factors.
+SolverOptions diversify(const SolverOptions& base, unsigned worker) {
+    SolverOptions options = base;
+    if (worker == 0) return options;
+    static const RestartMode restart_modes[] = {RestartMode::LUBY, RestartMode::GLUCOSE, RestartMode::GEOMETRIC};
+    static const PhaseMode phase_modes[] = {PhaseMode::TARGET, PhaseMode::SAVED, PhaseMode::ALWAYS_FALSE};
+    static const double var_decays[] = {0.95, 0.9, 0.99, 0.85};
+    options.seed = base.seed + worker * 0x9e3779b9u;
+    options.restart_mode = restart_modes[worker % 3];
+    options.phase_mode = phase_modes[(worker / 3) % 3];
+    options.var_decay = var_decays[(worker / 2) % 4];
+    options.random_branch_freq = worker % 4 == 3 ? 0.01 : base.random_branch_freq;
+    return options;
+}
+
+// Races options.threads diversified solvers, each on its own copy of formula, optionally
+// sharing learned clauses. The first to finish claims the result and raises the stop flag
+// that the others poll between decisions.
+SolveResult portfolio_solve(const Formula& formula, const SolverOptions& options) {
+    atomic<bool> stop(false);
+    atomic<int> winner(-1);
+    unique_ptr<ClauseExchange> exchange;
+    if (options.share) exchange = make_unique<ClauseExchange>(options.threads);
+    SolveResult result = UNKNOWN_RESULT;
+    vector<SolverStats> stats(options.threads);
+    vector<thread> workers;
+    for (unsigned i = 0; i < options.threads; ++i) {
+        workers.emplace_back([&, i] {
+            Formula copy = formula;
+            SolveResult answer = cdcl_solve(copy, diversify(options, i), {}, &stop, exchange.get(), i);
+            stats[i] = answer.stats[0];
+            if (answer.status == SolveStatus::UNKNOWN) return;
+            int expected = -1;
+            if (winner.compare_exchange_strong(expected, static_cast<int>(i))) {
+                result = move(answer);
+                stop.store(true, memory_order_relaxed);
+            }
+        });
+    }
+    for (thread& worker : workers) worker.join();
+    result.stats = move(stats);
+    return result;
+}
+
+// Lookahead cuber for cube-and-conquer: splits the formula into cubes (assumption sets) by
+// branching on the variable whose two phases both propagate the most, scored march-style by
+// the product of the assignments each phase implies. A phase that conflicts under lookahead
+// forces the other one into the cube; a variable with both phases conflicting refutes the cube.
+class Cuber {
+public:
+    static constexpr size_t CANDIDATES = 32;  // most frequent free variables looked ahead on per split
+
+    // Outcome of choosing a split: refuted cubes have no model; literal is Literal() when
+    // every variable is already assigned.
+    struct Split {
+        bool refuted;
+        Literal literal;
+    };
+
+    Cuber(const Formula& input)
+        : formula(input), assignments(input.max_variable), watches(input.max_variable),
+          order(input.max_variable, 0.95), occurrences(input.max_variable + 1, 0), consistent(true) {
+        for (ClauseRef ref : formula.clauses) {
+            const Clause& clause = formula.clause(ref);
+            for (const Literal& lit : clause) ++occurrences[lit.variable()];
+            if (clause.size() == 0) {
+                consistent = false;
+            } else if (clause.size() == 1) {
+                const Literal& unit = clause[0];
+                if (assignments.falsified(unit)) consistent = false;
+                if (!assignments.is_assigned(unit.variable())) assignments.assign(unit.variable(), !unit.negation(), ref);
+            } else {
+                watches.attach(formula, ref);
+            }
+        }
+        if (consistent) consistent = unit_propagation(formula, assignments, watches).first != "conflict";
+    }
+
+    // Cubes of up to depth split decisions, plus the literals lookahead forced, covering every
+    // model of the formula; empty if lookahead refuted it.
+    vector<vector<Literal>> make_cubes(unsigned depth) {
+        vector<vector<Literal>> cubes;
+        vector<Literal> cube;
+        if (consistent) split(cube, depth, cubes);
+        return cubes;
+    }
+
+    // Chooses how to split a cube further, for cubes the CDCL core found too hard.
+    Split split(const vector<Literal>& cube) {
+        Split result = {true, Literal()};
+        if (consistent) {
+            vector<Literal> extended = cube;
+            bool refuted = false;
+            for (const Literal& lit : cube) {
+                if (assignments.falsified(lit) || (!assignments.value(lit) && !assume(lit))) {
+                    refuted = true;
+                    break;
+                }
+            }
+            if (!refuted) result = select(extended);
+        }
+        backtrack(assignments, 0, order);
+        return result;
+    }
+
+private:
+    Formula formula;
+    Assignments assignments;
+    Watches watches;
+    VarOrder order;  // unused by lookahead, but backtrack keeps it up to date
+    vector<uint64_t> occurrences;
+    bool consistent;
+
+    bool assume(Literal lit) {
+        assignments.new_decision_level();
+        assignments.assign(lit.variable(), !lit.negation(), NO_REASON);
+        return unit_propagation(formula, assignments, watches).first != "conflict";
+    }
+
+    // Number of assignments lit implies, or -1 if it leads to a conflict.
+    int64_t lookahead(Literal lit) {
+        int level = assignments.decision_level();
+        size_t before = assignments.trail.size();
+        bool ok = assume(lit);
+        int64_t implied = static_cast<int64_t>(assignments.trail.size() - before);
+        backtrack(assignments, level, order);
+        return ok ? implied : -1;
+    }
+
+    Split select(vector<Literal>& cube) {
+        while (true) {
+            vector<int> candidates;
+            for (int var = 1; var < static_cast<int>(occurrences.size()); ++var) {
+                if (!assignments.is_assigned(var) && occurrences[var]) candidates.push_back(var);
+            }
+            if (candidates.empty()) return {false, Literal()};
+            size_t count = min(CANDIDATES, candidates.size());
+            partial_sort(candidates.begin(), candidates.begin() + count, candidates.end(),
+                         [&](int a, int b) { return occurrences[a] > occurrences[b]; });
+
+            Literal best;
+            int64_t best_score = -1;
+            bool forced = false;
+            for (size_t i = 0; i < count; ++i) {
+                int var = candidates[i];
+                if (assignments.is_assigned(var)) continue;
+                Literal positive(var, false);
+                int64_t pos = lookahead(positive);
+                int64_t neg = lookahead(positive.neg());
+                if (pos < 0 && neg < 0) return {true, Literal()};
+                if (pos < 0 || neg < 0) {
+                    Literal lit = pos < 0 ? positive.neg() : positive;
+                    assignments.assign(lit.variable(), !lit.negation(), NO_REASON);
+                    if (unit_propagation(formula, assignments, watches).first == "conflict") return {true, Literal()};
+                    cube.push_back(lit);
+                    forced = true;
+                    continue;
+                }
+                int64_t score = (pos + 1) * (neg + 1);
+                if (score > best_score) {
+                    best_score = score;
+                    best = pos >= neg ? positive : positive.neg();
+                }
+            }
+            // Forced literals change every score, so look again from the new assignment.
+            if (!forced) return {false, best};
+        }
+    }
+
+    void split(vector<Literal>& cube, unsigned depth, vector<vector<Literal>>& cubes) {
+        size_t mark = cube.size();
+        Split choice = depth ? select(cube) : Split{false, Literal()};
+        if (choice.refuted) {
+            cube.resize(mark);
+            return;
+        }
+        if (choice.literal == Literal()) {
+            cubes.push_back(cube);
+            cube.resize(mark);
+            return;
+        }
+        int level = assignments.decision_level();
+        for (Literal lit : {choice.literal, choice.literal.neg()}) {
+            if (assume(lit)) {
+                cube.push_back(lit);
+                split(cube, depth - 1, cubes);
+                cube.pop_back();
+            }
+            backtrack(assignments, level, order);
+        }
+        cube.resize(mark);
+    }
+};
+
+// Hands out cubes to cube-and-conquer workers and aggregates their answers: SAT as soon as
+// one cube has a model, UNSAT once every cube has been refuted. Cubes that a worker reports
+// as too hard are replaced by their two halves at the front of the queue, so the remaining
+// workers pick them up next.
+class CubeScheduler {
+public:
+    enum class Dispatch { CUBE, WAIT, DONE };
+
+    struct Job {
+        uint64_t id;
+        vector<Literal> cube;
+    };
+
+    CubeScheduler(vector<vector<Literal>> cubes) : next_id(0), result(UNSAT_RESULT) {
+        for (vector<Literal>& cube : cubes) pending.push_back({next_id++, move(cube)});
+    }
+
+    Dispatch take(Job& job) {
+        lock_guard<mutex> lock(guard);
+        if (finished_locked()) return Dispatch::DONE;
+        if (pending.empty()) return Dispatch::WAIT;
+        job = move(pending.front());
+        pending.pop_front();
+        running[job.id] = job.cube;
+        return Dispatch::CUBE;
+    }
+
+    void refuted(uint64_t id) {
+        lock_guard<mutex> lock(guard);
+        running.erase(id);
+    }
+
+    void satisfied(uint64_t id, Assignments model) {
+        lock_guard<mutex> lock(guard);
+        running.erase(id);
+        if (!result.model) result = {SolveStatus::SATISFIABLE, move(model), {}};
+    }
+
+    void split(uint64_t id, Literal lit) {
+        lock_guard<mutex> lock(guard);
+        auto it = running.find(id);
+        if (it == running.end()) return;
+        vector<Literal> cube = move(it->second);
+        running.erase(it);
+        cube.push_back(lit.neg());
+        pending.push_front({next_id++, cube});
+        cube.back() = lit;
+        pending.push_front({next_id++, move(cube)});
+    }
+
+    // Puts a cube back in the queue when its worker goes away without answering.
+    void abandon(uint64_t id) {
+        lock_guard<mutex> lock(guard);
+        auto it = running.find(id);
+        if (it == running.end()) return;
+        pending.push_front({id, move(it->second)});
+        running.erase(it);
+    }
+
+    bool finished() {
+        lock_guard<mutex> lock(guard);
+        return finished_locked();
+    }
+
+    SolveResult outcome() {
+        lock_guard<mutex> lock(guard);
+        return result;
+    }
+
+private:
+    mutex guard;
+    deque<Job> pending;
+    map<uint64_t, vector<Literal>> running;
+    uint64_t next_id;
+    SolveResult result;
+
+    bool finished_locked() const {
+        return result.model || (pending.empty() && running.empty());
+    }
+};
+
+// Newline-terminated text messages over a connected socket.
+class LineChannel {
+public:
+    explicit LineChannel(int fd) : fd(fd) {}
+
+    bool read_line(string& line) {
+        while (true) {
+            size_t end = buffer.find('\n');
+            if (end != string::npos) {
+                line.assign(buffer, 0, end);
+                buffer.erase(0, end + 1);
+                return true;
+            }
+            char chunk[1 << 16];
+            ssize_t got = recv(fd, chunk, sizeof(chunk), 0);
+            if (got < 0 && errno == EINTR) continue;
+            if (got <= 0) return false;
+            buffer.append(chunk, static_cast<size_t>(got));
+        }
+    }
+
+    bool write_line(const string& line) {
+        string data = line + '\n';
+        size_t sent = 0;
+        while (sent < data.size()) {
+            ssize_t put = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (put < 0 && errno == EINTR) continue;
+            if (put <= 0) return false;
+            sent += static_cast<size_t>(put);
+        }
+        return true;
+    }
+
+private:
+    int fd;
+    string buffer;
+};
+
+// Cube-and-conquer protocol, one request and one reply per line:
+//   worker: GET                  server: CUBE <id> <lits> 0 | WAIT | DONE
+//   worker: UNSAT <id> | SAT <id> <lits> 0 | SPLIT <id> <lit>
+// Literals are DIMACS integers; a SAT reply carries the whole model, which is checked against
+// formula. A malformed reply or a wrong model drops the connection and requeues its cube.
+void serve_cube_worker(int fd, const Formula& formula, CubeScheduler& scheduler) {
+    // Reads a literal of formula, or Literal() for the terminating 0; false if the value is
+    // missing or out of range.
+    auto read_literal = [&](istringstream& in, Literal& lit) {
+        long long value = 0;
+        if (!(in >> value) || value < -formula.max_variable || value > formula.max_variable) return false;
+        lit = value == 0 ? Literal() : Literal(static_cast<int>(value < 0 ? -value : value), value < 0);
+        return true;
+    };
+    LineChannel channel(fd);
+    uint64_t current = 0;  // cube the worker holds
+    bool busy = false;
+    string line;
+    while (channel.read_line(line)) {
+        istringstream in(line);
+        string command;
+        uint64_t id = 0;
+        in >> command;
+        if (command == "GET") {
+            CubeScheduler::Job job;
+            CubeScheduler::Dispatch dispatch = scheduler.take(job);
+            string reply = dispatch == CubeScheduler::Dispatch::DONE ? "DONE" : "WAIT";
+            if (dispatch == CubeScheduler::Dispatch::CUBE) {
+                current = job.id;
+                busy = true;
+                reply = "CUBE " + to_string(job.id);
+                for (const Literal& lit : job.cube) reply += " " + to_string(lit.to_dimacs());
+                reply += " 0";
+            }
+            if (!channel.write_line(reply)) break;
+        } else if (command == "UNSAT" && in >> id) {
+            scheduler.refuted(id);
+            busy = false;
+        } else if (command == "SAT" && in >> id) {
+            Assignments model(formula.max_variable);
+            Literal lit;
+            bool read = false;
+            while ((read = read_literal(in, lit)) && lit != Literal()) {
+                if (!model.is_assigned(lit.variable())) model.assign(lit.variable(), !lit.negation(), NO_REASON);
+            }
+            if (!read || !model.satisfy(formula)) break;
+            scheduler.satisfied(id, move(model));
+            busy = false;
+        } else if (command == "SPLIT" && in >> id) {
+            Literal lit;
+            if (!read_literal(in, lit) || lit == Literal()) break;
+            scheduler.split(id, lit);
+            busy = false;
+        } else {
+            break;
+        }
+    }
+    if (busy) scheduler.abandon(current);
+    // The worker sees the connection drop; serve_cubes closes it once the run is over.
+    shutdown(fd, SHUT_RDWR);
+}
+
+// Cube-and-conquer server: cubes the formula by lookahead, then serves the cubes to workers
+// connecting on options.cube_port until one finds a model or all are refuted.
+SolveResult serve_cubes(const Formula& formula, const SolverOptions& options) {
+    vector<vector<Literal>> cubes = Cuber(formula).make_cubes(options.cube_depth);
+    if (cubes.empty()) return UNSAT_RESULT;
+    CubeScheduler scheduler(move(cubes));
+
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    if (listener < 0) throw runtime_error(string("socket: ") + strerror(errno));
+    int yes = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(options.cube_port);
+    if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || listen(listener, 64) < 0) {
+        string error = strerror(errno);
+        close(listener);
+        throw runtime_error("cannot listen on port " + to_string(options.cube_port) + ": " + error);
+    }
+
+    vector<thread> handlers;
+    vector<int> connections;
+    while (!scheduler.finished()) {
+        pollfd ready = {listener, POLLIN, 0};
+        if (poll(&ready, 1, 100) <= 0) continue;
+        int fd = accept(listener, nullptr, nullptr);
+        if (fd < 0) continue;
+        connections.push_back(fd);
+        handlers.emplace_back(serve_cube_worker, fd, cref(formula), ref(scheduler));
+    }
+    close(listener);
+    // Workers still busy on a cube learn that the run is over when their connection drops.
+    for (int fd : connections) shutdown(fd, SHUT_RDWR);
+    for (thread& handler : handlers) handler.join();
+    for (int fd : connections) close(fd);
+    return scheduler.outcome();
+}
+
+// Cube-and-conquer worker: solves cubes from the server at address ("host:port") under
+// assumptions, giving each options.cube_conflicts conflicts before asking for it to be split.
+int run_cube_worker(const Formula& formula, const SolverOptions& options) {
+    size_t colon = options.cube_server.rfind(':');
+    string host = colon == string::npos ? "localhost" : options.cube_server.substr(0, colon);
+    string port = colon == string::npos ? options.cube_server : options.cube_server.substr(colon + 1);
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* addresses = nullptr;
+    int fd = -1;
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses) == 0) {
+        for (addrinfo* a = addresses; a && fd < 0; a = a->ai_next) {
+            fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+            if (fd >= 0 && connect(fd, a->ai_addr, a->ai_addrlen) < 0) {
+                close(fd);
+                fd = -1;
+            }
+        }
+        freeaddrinfo(addresses);
+    }
+    if (fd < 0) {
+        cout << "Unable to connect to " << options.cube_server << endl;
+        return 1;
+    }
+
+    LineChannel channel(fd);
+    Cuber cuber(formula);
+    // One incremental solver for all cubes, so clauses learned on one cube help with the next.
+    SolverOptions budgeted = options;
+    budgeted.max_conflicts = options.cube_conflicts;
+    Formula working = formula;
+    Solver solver(working, budgeted);
+    string line;
+    while (channel.write_line("GET") && channel.read_line(line)) {
+        istringstream in(line);
+        string command;
+        in >> command;
+        if (command == "WAIT") {
+            this_thread::sleep_for(chrono::milliseconds(100));
+            continue;
+        }
+        uint64_t id;
+        if (command != "CUBE" || !(in >> id)) break;
+        vector<Literal> cube;
+        int value;
+        while (in >> value && value != 0) cube.emplace_back(abs(value), value < 0);
+
+        SolveResult result = {solver.solve(cube), nullopt, {}};
+        if (result.status == SolveStatus::SATISFIABLE) result.model = solver.take_model();
+        // Only running out of cube conflicts asks for a split; any other budget ends the worker.
+        const char* limit = solver.stats().limit;
+        if (limit && strcmp(limit, "conflict limit") != 0) break;
+        string reply;
+        if (result.status == SolveStatus::UNKNOWN) {
+            Cuber::Split choice = cuber.split(cube);
+            if (choice.refuted) {
+                result = UNSAT_RESULT;
+            } else if (choice.literal != Literal()) {
+                reply = "SPLIT " + to_string(id) + " " + to_string(choice.literal.to_dimacs());
+            } else {
+                Formula copy = formula;
+                result = cdcl_solve(copy, options, cube);
+                if (result.status == SolveStatus::UNKNOWN) break;
+            }
+        }
+        if (result.status == SolveStatus::UNSATISFIABLE) {
+            reply = "UNSAT " + to_string(id);
+        } else if (result.status == SolveStatus::SATISFIABLE) {
+            reply = "SAT " + to_string(id);
+            for (int var = 1; var <= formula.max_variable; ++var) {
+                if (result.model->is_assigned(var)) {
+                    reply += " " + to_string(result.model->value(Literal(var, false)) ? var : -var);
+                }
+            }
+            reply += " 0";
+        }
+        if (!channel.write_line(reply)) break;
+    }
+    close(fd);
+    return 0;
+}
+
+// Byte source for the DIMACS scanner: one mapped region, or a sequence of buffered chunks.
+class InputSource {
+public:
+    virtual ~InputSource() = default;
+
+    // Points [begin, end) at the next chunk of input; returns false once the input is exhausted.
+    virtual bool next_chunk(const char*& begin, const char*& end) = 0;
+
+    // Bytes the source delivers in all, or 0 if that is not known up front.
+    virtual size_t size_hint() const {
+        return 0;
+    }
+};
+
+class MemorySource : public InputSource {
+public:
+    MemorySource(const char* data, size_t size) : data(data), size(size), consumed(false) {}
+
+    bool next_chunk(const char*& begin, const char*& end) override {
+        if (consumed) return false;
+        consumed = true;
+        begin = data;
+        end = data + size;
+        return true;
+    }
+
+    size_t size_hint() const override {
+        return size;
+    }
+
+private:
+    const char* data;
+    size_t size;
+    bool consumed;
+};
+
+// A regular file mapped read-only, so the scanner reads the page cache without copying.
+class MappedFile : public InputSource {
+public:
+    MappedFile(int fd, size_t size) : fd(fd), data(nullptr), size(size), consumed(false) {
+        if (size == 0) return;
+        void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) return;
+        madvise(mapped, size, MADV_SEQUENTIAL);
+        data = static_cast<const char*>(mapped);
+    }
+
+    ~MappedFile() override {
+        if (data) munmap(const_cast<char*>(data), size);
+        close(fd);
+    }
+
+    bool mapped() const {
+        return data != nullptr || size == 0;
+    }
+
+    bool next_chunk(const char*& begin, const char*& end) override {
+        if (consumed || size == 0) return false;
+        consumed = true;
+        begin = data;
+        end = data + size;
+        return true;
+    }
+
+    size_t size_hint() const override {
+        return size;
+    }
+
+private:
+    int fd;
+    const char* data;
+    size_t size;
+    bool consumed;
+};
+
+// Pipes and other unmappable inputs are read in large chunks through one reused buffer.
+class FileStream : public InputSource {
+public:
+    static constexpr size_t CHUNK_SIZE = 1 << 20;
+
+    FileStream(int fd) : fd(fd), buffer(CHUNK_SIZE) {}
+
+    ~FileStream() override {
+        close(fd);
+    }
+
+    bool next_chunk(const char*& begin, const char*& end) override {
+        ssize_t got;
+        do {
+            got = read(fd, buffer.data(), buffer.size());
+        } while (got < 0 && errno == EINTR);
+        if (got < 0) throw runtime_error(string("read failed: ") + strerror(errno));
+        if (got == 0) return false;
+        begin = buffer.data();
+        end = begin + got;
+        return true;
+    }
+
+private:
+    int fd;
+    vector<char> buffer;
+};
+
+// Replays a chunk that was already read (to sniff the format) before the rest of the source.
+class PrefetchedSource : public InputSource {
+public:
+    PrefetchedSource(unique_ptr<InputSource> raw, const char* begin, const char* end)
+        : raw(move(raw)), first_begin(begin), first_end(end), replayed(false) {}
+
+    bool next_chunk(const char*& begin, const char*& end) override {
+        if (!replayed) {
+            replayed = true;
+            begin = first_begin;
+            end = first_end;
+            return true;
+        }
+        return raw->next_chunk(begin, end);
+    }
+
+    size_t size_hint() const override {
+        return raw->size_hint();
+    }
+
+private:
+    unique_ptr<InputSource> raw;
+    const char* first_begin;
+    const char* first_end;
+    bool replayed;
+};
+
+// Decodes a compressed source one output chunk at a time, so the decompressed text is
+// never held in memory as a whole. Concatenated compressed streams are decoded in turn.
+class Decompressor : public InputSource {
+public:
+    static constexpr size_t CHUNK_SIZE = 1 << 20;
+
+    Decompressor(const string& format, unique_ptr<InputSource> raw, const char* begin, const char* end)
+        : format(format), raw(move(raw)), in(begin), in_end(end), output(CHUNK_SIZE), output_full(false),
+          at_stream_end(false) {}
+
+    bool next_chunk(const char*& begin, const char*& end) override {
+        while (true) {
+            // A full output buffer may leave decoded bytes inside the codec; drain them first.
+            if (in == in_end && !output_full && !raw->next_chunk(in, in_end)) {
+                if (!at_stream_end) throw runtime_error(format + " input is truncated");
+                return false;
+            }
+            size_t produced = decode(output.data(), output.size());
+            output_full = produced == output.size();
+            if (produced > 0) {
+                begin = output.data();
+                end = begin + produced;
+                return true;
+            }
+        }
+    }
+
+protected:
+    string format;
+
+    // Decodes from [in, in_end) into out, advancing in. Sets at_stream_end after a complete
+    // stream (and prepares for a following one), clears it once new stream data is consumed.
+    virtual size_t decode(char* out, size_t out_size) = 0;
+
+    [[noreturn]] void corrupt(const string& detail) const {
+        throw runtime_error("corrupt " + format + " input: " + detail);
+    }
+
+    unique_ptr<InputSource> raw;
+    const char* in;
+    const char* in_end;
+    vector<char> output;
+    bool output_full;
+    bool at_stream_end;
+};
+
+#ifdef SAT_USE_ZLIB
+class GzipSource : public Decompressor {
+public:
+    GzipSource(unique_ptr<InputSource> raw, const char* begin, const char* end)
+        : Decompressor("gzip", move(raw), begin, end), stream{} {
+        if (inflateInit2(&stream, 15 + 16) != Z_OK) throw runtime_error("cannot initialise zlib");
+    }
+
+    ~GzipSource() override {
+        inflateEnd(&stream);
+    }
+
+protected:
+    size_t decode(char* out, size_t out_size) override {
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in));
+        stream.avail_in = static_cast<uInt>(min<size_t>(in_end - in, UINT32_MAX));
+        stream.next_out = reinterpret_cast<Bytef*>(out);
+        stream.avail_out = static_cast<uInt>(out_size);
+        int rc = inflate(&stream, Z_NO_FLUSH);
+        const char* consumed_to = reinterpret_cast<const char*>(stream.next_in);
+        if (consumed_to != in) at_stream_end = false;
+        in = consumed_to;
+        if (rc == Z_STREAM_END) {
+            at_stream_end = true;
+            inflateReset(&stream);
+        } else if (rc != Z_OK && rc != Z_BUF_ERROR) {
+            corrupt(stream.msg ? stream.msg : "inflate failed");
+        }
+        return out_size - stream.avail_out;
+    }
+
+private:
+    z_stream stream;
+};
+#endif
+
+#ifdef SAT_USE_LZMA
+class XzSource : public Decompressor {
+public:
+    XzSource(unique_ptr<InputSource> raw, const char* begin, const char* end)
+        : Decompressor("xz", move(raw), begin, end), stream(LZMA_STREAM_INIT) {
+        init();
+    }
+
+    ~XzSource() override {
+        lzma_end(&stream);
+    }
+
+protected:
+    size_t decode(char* out, size_t out_size) override {
+        stream.next_in = reinterpret_cast<const uint8_t*>(in);
+        stream.avail_in = in_end - in;
+        stream.next_out = reinterpret_cast<uint8_t*>(out);
+        stream.avail_out = out_size;
+        lzma_ret rc = lzma_code(&stream, LZMA_RUN);
+        const char* consumed_to = reinterpret_cast<const char*>(stream.next_in);
+        if (consumed_to != in) at_stream_end = false;
+        in = consumed_to;
+        if (rc == LZMA_STREAM_END) {
+            at_stream_end = true;
+            init();
+        } else if (rc != LZMA_OK && rc != LZMA_BUF_ERROR) {
+            corrupt("lzma error " + std::to_string(rc));
+        }
+        return out_size - stream.avail_out;
+    }
+
+private:
+    lzma_stream stream;
+
+    void init() {
+        if (lzma_stream_decoder(&stream, UINT64_MAX, 0) != LZMA_OK) throw runtime_error("cannot initialise liblzma");
+    }
+};
+#endif
+
+#ifdef SAT_USE_BZIP2
+class Bzip2Source : public Decompressor {
+public:
+    Bzip2Source(unique_ptr<InputSource> raw, const char* begin, const char* end)
+        : Decompressor("bzip2", move(raw), begin, end), stream{} {
+        init();
+    }
+
+    ~Bzip2Source() override {
+        BZ2_bzDecompressEnd(&stream);
+    }
+
+protected:
+    size_t decode(char* out, size_t out_size) override {
+        stream.next_in = const_cast<char*>(in);
+        stream.avail_in = static_cast<unsigned>(min<size_t>(in_end - in, UINT32_MAX));
+        stream.next_out = out;
+        stream.avail_out = static_cast<unsigned>(out_size);
+        int rc = BZ2_bzDecompress(&stream);
+        if (stream.next_in != in) at_stream_end = false;
+        in = stream.next_in;
+        size_t produced = out_size - stream.avail_out;
+        if (rc == BZ_STREAM_END) {
+            at_stream_end = true;
+            BZ2_bzDecompressEnd(&stream);
+            init();
+        } else if (rc != BZ_OK) {
+            corrupt("bzip2 error " + std::to_string(rc));
+        }
+        return produced;
+    }
+
+private:
+    bz_stream stream;
+
+    void init() {
+        stream = bz_stream{};
+        if (BZ2_bzDecompressInit(&stream, 0, 0) != BZ_OK) throw runtime_error("cannot initialise libbz2");
+    }
+};
+#endif
+
+bool has_magic(const char* begin, const char* end, const char* magic, size_t length) {
+    return static_cast<size_t>(end - begin) >= length && memcmp(begin, magic, length) == 0;
+}
+
+// Picks a decoder from the leading magic bytes; plain text is passed through.
+unique_ptr<InputSource> detect_compression(unique_ptr<InputSource> raw) {
+    const char* begin;
+    const char* end;
+    if (!raw->next_chunk(begin, end)) return make_unique<MemorySource>(nullptr, 0);
+
+    string format;
+    if (has_magic(begin, end, "\x1f\x8b", 2)) {
+#ifdef SAT_USE_ZLIB
+        return make_unique<GzipSource>(move(raw), begin, end);
+#endif
+        format = "gzip";
+    } else if (has_magic(begin, end, "\xfd" "7zXZ\0", 6)) {
+#ifdef SAT_USE_LZMA
+        return make_unique<XzSource>(move(raw), begin, end);
+#endif
+        format = "xz";
+    } else if (has_magic(begin, end, "BZh", 3)) {
+#ifdef SAT_USE_BZIP2
+        return make_unique<Bzip2Source>(move(raw), begin, end);
+#endif
+        format = "bzip2";
+    }
+    if (!format.empty()) throw runtime_error(format + " input is not supported by this build");
+    return make_unique<PrefetchedSource>(move(raw), begin, end);
+}
+
+// Opens a DIMACS file (or "-" for stdin) for parsing, decompressing gzip, xz and bzip2
+// input on the fly; returns nullptr if it cannot be opened.
+unique_ptr<InputSource> open_input(const string& filename) {
+    int fd = filename == "-" ? dup(STDIN_FILENO) : open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return nullptr;
+    struct stat info;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode)) {
+        auto file = make_unique<MappedFile>(fd, static_cast<size_t>(info.st_size));
+        if (file->mapped()) return detect_compression(move(file));
+        fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0) return nullptr;
+    }
+    return detect_compression(make_unique<FileStream>(fd));
+}
+
+// Hand-written DIMACS CNF scanner. Literals go straight into the formula's clause arena,
+// the "p cnf V C" header pre-sizes the formula, and errors report the offending line.
+class DimacsParser {
+public:
+    DimacsParser(InputSource& source) : source(source), pos(nullptr), end(nullptr), line(1) {}
+
+    Formula parse() {
+        Formula formula;
+        parse(formula);
+        return formula;
+    }
+
+    // Reads the clauses into formula, which must be empty; a cleared one reuses its arena.
+    void parse(Formula& formula) {
+        bool in_clause = false;
+        ClauseRef current = 0;
+        size_t clause_line = 0;
+        while (true) {
+            skip_whitespace();
+            int c = peek();
+            if (c == EOF || c == '%') break;  // SATLIB files end their data with a % line
+            if (c == 'c') {
+                skip_line();
+            } else if (c == 'p') {
+                if (in_clause) error("header inside a clause");
+                parse_header(formula);
+            } else if (c == '-' || isdigit(c)) {
+                int lit = read_int();
+                if (!in_clause) {
+                    current = formula.arena.open_clause(false);
+                    in_clause = true;
+                    clause_line = line;
+                }
+                if (lit == 0) {
+                    formula.arena.close_clause(current);
+                    formula.clauses.push_back(current);
+                    in_clause = false;
+                } else {
+                    int var = abs(lit);
+                    formula.note_variable(var);
+                    formula.arena.push_literal(Literal(var, lit < 0));
+                }
+            } else {
+                error(string("unexpected character '") + static_cast<char>(c) + "'");
+            }
+        }
+        if (in_clause) {
+            line = clause_line;
+            error("clause is not terminated by 0");
+        }
+    }
+
+private:
+    // Literals must fit the 32-bit encoding 2 * variable + negation.
+    static constexpr int64_t MAX_VARIABLE = (int64_t(1) << 31) - 1;
+    // Most clauses and variables the header pre-sizes for when the input size is unknown.
+    static constexpr size_t HINT_CEILING = size_t(1) << 20;
+
+    InputSource& source;
+    const char* pos;
+    const char* end;
+    size_t line;
+
+    [[noreturn]] void error(const string& message) const {
+        throw runtime_error("line " + std::to_string(line) + ": " + message);
+    }
+
+    int peek() {
+        if (pos == end && !source.next_chunk(pos, end)) return EOF;
+        return static_cast<unsigned char>(*pos);
+    }
+
+    void skip_whitespace() {
+        for (int c = peek(); c == ' ' || c == '\t' || c == '\r' || c == '\n'; c = peek()) {
+            if (c == '\n') ++line;
+            ++pos;
+        }
+    }
+
+    void skip_line() {
+        for (int c = peek(); c != EOF; c = peek()) {
+            ++pos;
+            if (c == '\n') {
+                ++line;
+                return;
+            }
+        }
+    }
+
+    void skip_blanks() {
+        for (int c = peek(); c == ' ' || c == '\t'; c = peek()) ++pos;
+    }
+
+    int read_int() {
+        bool negative = false;
+        if (peek() == '-') {
+            negative = true;
+            ++pos;
+        }
+        int c = peek();
+        if (!isdigit(c)) error("expected a number");
+        int64_t value = 0;
+        for (; isdigit(c); c = peek()) {
+            value = value * 10 + (c - '0');
+            if (value > MAX_VARIABLE) error("number out of range");
+            ++pos;
+        }
+        if (c != EOF && c != ' ' && c != '\t' && c != '\r' && c != '\n') {
+            error(string("unexpected character '") + static_cast<char>(c) + "' in number");
+        }
+        return static_cast<int>(negative ? -value : value);
+    }
+
+    void parse_header(Formula& formula) {
+        ++pos;
+        skip_blanks();
+        for (const char* expected = "cnf"; *expected; ++expected) {
+            if (peek() != *expected) error("expected 'p cnf <variables> <clauses>'");
+            ++pos;
+        }
+        skip_blanks();
+        int variables = read_int();
+        skip_blanks();
+        int clauses = read_int();
+        if (variables < 0 || clauses < 0) error("negative count in header");
+        // The counts are only a hint. Every clause and every variable takes at least two bytes
+        // of input, so the tables are pre-sized no further than the input size allows, or than
+        // a fixed ceiling when the size is not known; they grow as needed past that.
+        size_t limit = source.size_hint() ? source.size_hint() / 2 : HINT_CEILING;
+        formula.occurs.resize(min(static_cast<size_t>(variables), limit) + 1, 0);
+        size_t expected = min(static_cast<size_t>(clauses), limit);
+        formula.clauses.reserve(expected);
+        // Assume short clauses; the arena still grows if the guess is low.
+        formula.arena.reserve(expected * (ClauseArena::HEADER_WORDS + 3));
+    }
+};
+
+Formula parse_dimacs_cnf(InputSource& source) {
+    return DimacsParser(source).parse();
+}
+
+void parse_dimacs_cnf(InputSource& source, Formula& formula) {
+    DimacsParser(source).parse(formula);
+}
+
+Formula parse_dimacs_cnf(const string& content) {
+    MemorySource source(content.data(), content.size());
+    return parse_dimacs_cnf(source);
+}
+
+// One benchmark run, as written to result files and read back from a baseline.
+struct BenchResult {
+    string instance;
+    string status;  // SAT, UNSAT, UNKNOWN, TIMEOUT, MEMOUT or ERROR
+    double wall = 0;
+    double parse = 0;
+    double simplify = 0;
+    double search = 0;
+    uint64_t conflicts = 0;
+    uint64_t decisions = 0;
+    uint64_t propagations = 0;
+    long peak_rss_kb = 0;
+
+    bool solved() const {
+        return status == "SAT" || status == "UNSAT";
+    }
+
+    double propagations_per_second() const {
+        double seconds = simplify + search;
+        return seconds > 0 ? static_cast<double>(propagations) / seconds : 0;
+    }
+};
+
+// Par-2 score: the wall time of every solved instance plus twice the timeout for the others.
+double par2(const vector<BenchResult>& results, double timeout) {
+    double score = 0;
+    for (const BenchResult& result : results) score += result.solved() ? result.wall : 2 * timeout;
+    return score;
+}
+
+// The instances of a suite: the regular files of a directory in name order, or the paths listed
+// in a file, one per line and relative to its directory; '#' starts a comment line.
+vector<string> bench_instances(const string& suite) {
+    struct stat info;
+    if (stat(suite.c_str(), &info) != 0) throw runtime_error("cannot open " + suite);
+    vector<string> paths;
+    if (S_ISDIR(info.st_mode)) {
+        DIR* dir = opendir(suite.c_str());
+        if (!dir) throw runtime_error("cannot list " + suite);
+        while (dirent* entry = readdir(dir)) {
+            string path = suite + "/" + entry->d_name;
+            if (entry->d_name[0] != '.' && stat(path.c_str(), &info) == 0 && S_ISREG(info.st_mode)) paths.push_back(path);
+        }
+        closedir(dir);
+        sort(paths.begin(), paths.end());
+        return paths;
+    }
+    ifstream list(suite);
+    size_t slash = suite.rfind('/');
+    string base = slash == string::npos ? "" : suite.substr(0, slash + 1);
+    for (string line; getline(list, line);) {
+        line.erase(0, line.find_first_not_of(" \t\r"));
+        line.erase(line.find_last_not_of(" \t\r") + 1);
+        if (line.empty() || line[0] == '#') continue;
+        paths.push_back(line[0] == '/' ? line : base + line);
+    }
+    return paths;
+}
+
+// Solves one instance in a child process, with its address space capped at options.bench_memory
+// MiB and killed after options.bench_timeout seconds. The child reports its counters through a
+// pipe; the peak resident set size comes from the kernel's accounting of the child.
+BenchResult run_bench_instance(const string& path, const SolverOptions& options) {
+    static constexpr int MEMOUT_EXIT = 3;
+    BenchResult result;
+    result.instance = path;
+    int fds[2];
+    if (pipe(fds) != 0) throw runtime_error(string("pipe failed: ") + strerror(errno));
+    auto start = chrono::steady_clock::now();
+    pid_t pid = fork();
+    if (pid < 0) throw runtime_error(string("fork failed: ") + strerror(errno));
+    if (pid == 0) {
+        close(fds[0]);
+        if (options.bench_memory) {
+            rlimit limit;
+            limit.rlim_cur = limit.rlim_max = static_cast<rlim_t>(options.bench_memory) << 20;
+            setrlimit(RLIMIT_AS, &limit);
+        }
+        string report;
+        try {
+            unique_ptr<InputSource> input = open_input(path);
+            if (!input) _exit(1);
+            Formula formula = parse_dimacs_cnf(*input);
+            double parse = seconds_since(start);
+            SolveResult result = engine_solve(formula, options);
+            const SolverStats& stats = result.stats[0];
+            report = string(status_name(result.status)) + " " + to_string(parse) + " " + to_string(stats.simplify_seconds) + " " +
+                     to_string(stats.search_seconds) + " " + to_string(stats.conflicts) + " " +
+                     to_string(stats.decisions) + " " + to_string(stats.propagations) + "\n";
+        } catch (const bad_alloc&) {
+            _exit(MEMOUT_EXIT);
+        } catch (const exception&) {
+            _exit(1);
+        }
+        for (size_t done = 0; done < report.size();) {
+            ssize_t wrote = write(fds[1], report.data() + done, report.size() - done);
+            if (wrote <= 0) _exit(1);
+            done += static_cast<size_t>(wrote);
+        }
+        _exit(0);
+    }
+
+    close(fds[1]);
+    string report;
+    bool timed_out = false;
+    char buffer[256];
+    while (true) {
+        double left = options.bench_timeout - seconds_since(start);
+        if (left <= 0) {
+            kill(pid, SIGKILL);
+            timed_out = true;
+            break;
+        }
+        pollfd readable = {fds[0], POLLIN, 0};
+        int ready = poll(&readable, 1, static_cast<int>(ceil(left * 1000)));
+        if (ready <= 0) continue;  // timeout or EINTR: the deadline is checked again
+        ssize_t got = read(fds[0], buffer, sizeof(buffer));
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) break;  // the child exited
+        report.append(buffer, static_cast<size_t>(got));
+    }
+    close(fds[0]);
+    int status = 0;
+    rusage usage;
+    while (wait4(pid, &status, 0, &usage) < 0 && errno == EINTR) {
+    }
+    result.wall = seconds_since(start);
+    result.peak_rss_kb = usage.ru_maxrss;
+
+    istringstream fields(report);
+    if (timed_out) {
+        result.status = "TIMEOUT";
+    } else if (WIFEXITED(status) && WEXITSTATUS(status) == MEMOUT_EXIT) {
+        result.status = "MEMOUT";
+    } else if (!WIFEXITED(status) || WEXITSTATUS(status) != 0 ||
+               !(fields >> result.status >> result.parse >> result.simplify >> result.search >> result.conflicts >>
+                 result.decisions >> result.propagations)) {
+        result.status = "ERROR";
+    }
+    return result;
+}
+
+string json_escape(const string& text) {
+    string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') escaped += '\\';
+        escaped += c;
+    }
+    return escaped;
+}
+
+const char* BENCH_CSV_HEADER =
+    "instance,status,wall_s,parse_s,simplify_s,search_s,conflicts,decisions,propagations,props_per_s,peak_rss_kb\n";
+
+// One result as a CSV line, or as a JSON object on one line without a separator.
+void write_bench_row(ostream& out, const BenchResult& r, bool json) {
+    out << fixed << setprecision(3);
+    if (json) {
+        out << "  {\"instance\": \"" << json_escape(r.instance) << "\", \"status\": \"" << r.status
+            << "\", \"wall_s\": " << r.wall << ", \"parse_s\": " << r.parse << ", \"simplify_s\": " << r.simplify
+            << ", \"search_s\": " << r.search << ", \"conflicts\": " << r.conflicts << ", \"decisions\": " << r.decisions
+            << ", \"propagations\": " << r.propagations << ", \"props_per_s\": " << r.propagations_per_second()
+            << ", \"peak_rss_kb\": " << r.peak_rss_kb << "}";
+    } else {
+        out << r.instance << "," << r.status << "," << r.wall << "," << r.parse << "," << r.simplify << "," << r.search
+            << "," << r.conflicts << "," << r.decisions << "," << r.propagations << "," << r.propagations_per_second()
+            << "," << r.peak_rss_kb;
+    }
+}
+
+// CSV with a header line, or a JSON array holding one object per line.
+void write_bench_results(ostream& out, const vector<BenchResult>& results, bool json) {
+    out << (json ? "[\n" : BENCH_CSV_HEADER);
+    for (size_t i = 0; i < results.size(); ++i) {
+        write_bench_row(out, results[i], json);
+        out << (json && i + 1 < results.size() ? ",\n" : "\n");
+    }
+    if (json) out << "]\n";
+}
+
+bool is_json_path(const string& path) {
+    return path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+}
+
+// Reads back the instance, status and wall time of results written by write_bench_results.
+vector<BenchResult> read_bench_results(const string& path) {
+    ifstream in(path);
+    if (!in) throw runtime_error("cannot open " + path);
+    bool json = is_json_path(path);
+    vector<BenchResult> results;
+    auto json_field = [](const string& line, const string& key) -> string {
+        size_t at = line.find("\"" + key + "\": ");
+        if (at == string::npos) return "";
+        at += key.size() + 4;
+        if (line[at] != '"') return line.substr(at, line.find_first_of(",}", at) - at);
+        string value;
+        for (size_t i = at + 1; i < line.size() && line[i] != '"'; ++i) {
+            if (line[i] == '\\') ++i;
+            value += line[i];
+        }
+        return value;
+    };
+    bool header = !json;
+    for (string line; getline(in, line);) {
+        if (header) {
+            header = false;
+            continue;
+        }
+        BenchResult result;
+        if (json) {
+            result.instance = json_field(line, "instance");
+            result.status = json_field(line, "status");
+            string wall = json_field(line, "wall_s");
+            if (result.instance.empty() || wall.empty()) continue;
+            result.wall = stod(wall);
+        } else {
+            // The instance may itself contain commas; the other fields cannot.
+            vector<string> fields;
+            size_t end = line.size();
+            for (int k = 0; k < 10 && end != string::npos; ++k) {
+                size_t comma = line.rfind(',', end - 1);
+                if (comma == string::npos) break;
+                fields.push_back(line.substr(comma + 1, end - comma - 1));
+                end = comma;
+            }
+            if (fields.size() != 10) continue;
+            result.instance = line.substr(0, end);
+            result.status = fields[9];
+            result.wall = stod(fields[8]);
+        }
+        results.push_back(result);
+    }
+    return results;
+}
+
+// Benchmark mode: solves every instance of options.bench in its own capped process, prints one
+// line per instance and a Par-2 summary, and writes the results to options.bench_output. Against
+// a baseline, flags instances that lost their answer, disagree with it or got markedly slower;
+// returns 1 if there is any such regression.
+int run_bench(const SolverOptions& options) {
+    static constexpr double SLOWDOWN = 1.25;    // slower than the baseline by this factor
+    static constexpr double NOISE_SECONDS = 0.1;  // and by at least this much wall time
+    vector<string> instances = bench_instances(options.bench);
+    vector<BenchResult> results;
+    cout << fixed << setprecision(3);
+    for (const string& path : instances) {
+        cout.flush();
+        BenchResult result = run_bench_instance(path, options);
+        cout << path << " " << result.status << " " << result.wall << "s conflicts " << result.conflicts << " decisions "
+             << result.decisions << " props/s " << setprecision(0) << result.propagations_per_second()
+             << setprecision(3) << " rss " << result.peak_rss_kb << "KB" << endl;
+        results.push_back(result);
+    }
+    size_t solved = count_if(results.begin(), results.end(), [](const BenchResult& r) { return r.solved(); });
+    cout << "Solved " << solved << " of " << results.size() << ", PAR-2 " << par2(results, options.bench_timeout) << endl;
+
+    if (!options.bench_output.empty()) {
+        ofstream out(options.bench_output);
+        write_bench_results(out, results, is_json_path(options.bench_output));
+        if (!out) throw runtime_error("cannot write " + options.bench_output);
+    }
+    if (options.bench_baseline.empty()) return 0;
+
+    map<string, BenchResult> baseline;
+    for (BenchResult& old : read_bench_results(options.bench_baseline)) baseline[old.instance] = old;
+    vector<BenchResult> before, after;
+    size_t regressions = 0;
+    for (const BenchResult& now : results) {
+        auto entry = baseline.find(now.instance);
+        if (entry == baseline.end()) continue;
+        const BenchResult& old = entry->second;
+        before.push_back(old);
+        after.push_back(now);
+        const char* verdict = nullptr;
+        if (old.solved() && now.solved() && old.status != now.status) {
+            verdict = "MISMATCH";
+        } else if (old.solved() && !now.solved()) {
+            verdict = "LOST";
+        } else if (!old.solved() && now.solved()) {
+            verdict = "GAINED";
+        } else if (now.solved() && now.wall > old.wall * SLOWDOWN && now.wall - old.wall > NOISE_SECONDS) {
+            verdict = "SLOWER";
+        } else if (now.solved() && old.wall > now.wall * SLOWDOWN && old.wall - now.wall > NOISE_SECONDS) {
+            verdict = "FASTER";
+        }
+        if (!verdict) continue;
+        bool regression = strcmp(verdict, "GAINED") != 0 && strcmp(verdict, "FASTER") != 0;
+        regressions += regression;
+        cout << verdict << " " << now.instance << ": " << old.status << " " << old.wall << "s -> " << now.status << " "
+             << now.wall << "s" << endl;
+    }
+    cout << "Baseline PAR-2 " << par2(before, options.bench_timeout) << " -> " << par2(after, options.bench_timeout)
+         << " on " << after.size() << " common instances, " << regressions << " regressions" << endl;
+    return regressions ? 1 : 0;
+}
+
+// Job deques of the batch workers. A worker takes jobs from the front of its own deque and, once
+// that is empty, steals from the back of another's, so the load evens out when a few instances
+// take much longer than the rest. Jobs are whole instances, which makes a lock per deque cheap.
+class WorkStealingQueues {
+public:
+    explicit WorkStealingQueues(size_t workers) : queues(workers) {}
+
+    void push(size_t worker, size_t job) {
+        Queue& queue = queues[worker];
+        lock_guard<mutex> guard(queue.lock);
+        queue.jobs.push_back(job);
+    }
+
+    // The next job for worker; false once every deque is empty, which is final because all
+    // jobs are pushed before the workers start.
+    bool pop(size_t worker, size_t& job) {
+        for (size_t k = 0; k < queues.size(); ++k) {
+            Queue& queue = queues[(worker + k) % queues.size()];
+            lock_guard<mutex> guard(queue.lock);
+            if (queue.jobs.empty()) continue;
+            if (k == 0) {
+                job = queue.jobs.front();
+                queue.jobs.pop_front();
+            } else {
+                job = queue.jobs.back();
+                queue.jobs.pop_back();
+            }
+            return true;
+        }
+        return false;
+    }
+
+private:
+    struct alignas(64) Queue {
+        mutex lock;
+        deque<size_t> jobs;
+    };
+    vector<Queue> queues;
+};
+
+// One batch worker: solves the jobs it gets from queues with a single solver and formula, reset
+// between instances so the arena and the per-variable tables are allocated once. Each instance
+// gets the solver's own time and conflict limits; emit receives every result as it is known.
+template <typename Config, typename Emit>
+void run_batch_worker(unsigned worker, WorkStealingQueues& queues, const vector<string>& instances,
+                      const SolverOptions& options, Emit&& emit) {
+    Formula formula;
+    BasicSolver<Config> solver(formula, options);
+    size_t job;
+    while (!interrupt_requested.load(memory_order_relaxed) && queues.pop(worker, job)) {
+        BenchResult result;
+        result.instance = instances[job];
+        auto start = chrono::steady_clock::now();
+        try {
+            unique_ptr<InputSource> input = open_input(result.instance);
+            if (!input) throw runtime_error("cannot open " + result.instance);
+            parse_dimacs_cnf(*input, formula);
+            result.parse = seconds_since(start);
+            SolveStatus status = solver.solve();
+            SolverStats stats = solver.stats();
+            result.status = !stats.limit                              ? status_name(status)
+                            : strcmp(stats.limit, "time limit") == 0   ? "TIMEOUT"
+                            : strcmp(stats.limit, "memory limit") == 0 ? "MEMOUT"
+                                                                       : "UNKNOWN";
+            result.simplify = stats.simplify_seconds;
+            result.search = stats.search_seconds;
+            result.conflicts = stats.conflicts;
+            result.decisions = stats.decisions;
+            result.propagations = stats.propagations;
+        } catch (const bad_alloc&) {
+            result.status = "MEMOUT";
+        } catch (const exception&) {
+            result.status = "ERROR";
+        }
+        solver.reset();
+        result.wall = seconds_since(start);
+        emit(result);
+    }
+}
+
+// Batch mode: solves every instance of options.batch in this process on options.jobs worker
+// threads, and streams one result line per instance to options.batch_output (or standard output)
+// in the order they finish, as CSV, or as JSON objects if the name ends in .json. The lines
+// have the benchmark columns, so they can serve as a --baseline; peak_rss_kb is 0, since the
+// instances share one process. Returns 1 if the results could not be written.
+int run_batch(const SolverOptions& options) {
+    vector<string> instances = bench_instances(options.batch);
+    ofstream file;
+    if (!options.batch_output.empty()) {
+        file.open(options.batch_output);
+        if (!file) throw runtime_error("cannot write " + options.batch_output);
+    }
+    ostream& out = options.batch_output.empty() ? cout : file;
+    bool json = is_json_path(options.batch_output);
+    if (!json) out << BENCH_CSV_HEADER << flush;
+
+    unsigned jobs = options.jobs ? options.jobs : max(1u, thread::hardware_concurrency());
+    jobs = static_cast<unsigned>(max<size_t>(1, min<size_t>(jobs, instances.size())));
+    WorkStealingQueues queues(jobs);
+    // Contiguous blocks: each worker follows the list order, thieves take the far end of a block.
+    for (size_t i = 0; i < instances.size(); ++i) queues.push(i * jobs / instances.size(), i);
+
+    auto start = chrono::steady_clock::now();
+    mutex output;
+    size_t done = 0, solved = 0;
+    auto emit = [&](const BenchResult& result) {
+        lock_guard<mutex> guard(output);
+        write_bench_row(out, result, json);
+        out << endl;
+        ++done;
+        solved += result.solved();
+    };
+    vector<thread> workers;
+    for (unsigned worker = 0; worker < jobs; ++worker) {
+        workers.emplace_back([&, worker] {
+            if (options.engine == Engine::LEAN) {
+                run_batch_worker<LeanConfig>(worker, queues, instances, options, emit);
+            } else {
+                run_batch_worker<FullConfig>(worker, queues, instances, options, emit);
+            }
+        });
+    }
+    for (thread& worker : workers) worker.join();
+    cerr << fixed << setprecision(3) << "c solved " << solved << " of " << done << " instances ("
+         << instances.size() << " listed) in " << seconds_since(start) << "s on " << jobs << " workers" << endl;
+    return out ? 0 : 1;
+}
+
+// Statistics of every solver behind result, as one JSON object.
+void write_stats_json(const string& path, const SolveResult& result, double wall) {
+    ofstream out(path);
+    out << fixed << setprecision(3) << "{\"status\": \"" << status_name(result.status) << "\", \"wall_s\": " << wall
+        << ", \"solvers\": [";
+    for (size_t i = 0; i < result.stats.size(); ++i) out << (i ? ", " : "") << result.stats[i].to_json();
+    out << "]}\n";
+    if (!out) throw runtime_error("cannot write " + path);
+}
+
+// Appends the competition "v" lines of model over variables 1..max_variable, at most 80
+// characters each, ending with 0.
+void append_model(string& out, const Assignments& model, int max_variable) {
+    char digits[16];
+    size_t line_start = out.size();
+    out += 'v';
+    for (int var = 1; var <= max_variable + 1; ++var) {
+        int lit = var > max_variable ? 0 : model.value(Literal(var, false)) ? var : -var;
+        char* end = to_chars(digits, digits + sizeof(digits), lit).ptr;
+        size_t length = static_cast<size_t>(end - digits);
+        if (out.size() - line_start + 1 + length > 80) {
+            out += "\nv";
+            line_start = out.size() - 1;
+        }
+        out += ' ';
+        out.append(digits, length);
+    }
+    out += '\n';
+}
+
+// Prints the answer in competition format, "s" line first and the model (if any) in "v" lines,
+// to standard output or options.model_file. Returns the exit code: 10 for SAT, 20 for UNSAT,
+// 0 for UNKNOWN and 1 if the model fails verification against input or cannot be written.
+int report_result(const SolveResult& result, const SolverOptions& options, const Formula* input, int max_variable) {
+    string out;
+    if (result.status == SolveStatus::UNSATISFIABLE) {
+        out = "s UNSATISFIABLE\n";
+    } else if (result.status == SolveStatus::UNKNOWN) {
+        const char* limit = "stop request";
+        for (const SolverStats& stats : result.stats) {
+            if (stats.limit) limit = stats.limit;
+        }
+        out = string("c stopped by the ") + limit + "\ns UNKNOWN\n";
+    } else {
+        if (input) {
+            if (!result.model->satisfy(*input)) {
+                cout << "c the model falsifies an input clause" << endl;
+                return 1;
+            }
+            out = "c model verified against " + to_string(input->clauses.size()) + " input clauses\n";
+        }
+        out += "s SATISFIABLE\n";
+        if (options.model_file.empty()) {
+            append_model(out, *result.model, max_variable);
+        } else {
+            string model = "s SATISFIABLE\n";
+            append_model(model, *result.model, max_variable);
+            ofstream file(options.model_file);
+            file << model;
+            if (!file.flush()) {
+                cout << "Unable to write the model to " << options.model_file << endl;
+                return 1;
+            }
+        }
+    }
+    fwrite(out.data(), 1, out.size(), stdout);
+    fflush(stdout);
+    return result.status == SolveStatus::SATISFIABLE ? 10 : result.status == SolveStatus::UNSATISFIABLE ? 20 : 0;
+}
+
+// Parses "[options] file.cnf" or "[options] --bench suite"; returns false on unknown or malformed arguments.
+bool parse_arguments(int argc, char* argv[], SolverOptions& options, string& filename) {
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        try {
+            if (arg == "--seed" && has_value) {
+                options.seed = static_cast<uint32_t>(stoul(argv[++i]));
+            } else if (arg == "--random-freq" && has_value) {
+                options.random_branch_freq = stod(argv[++i]);
+            } else if (arg == "--var-decay" && has_value) {
+                options.var_decay = stod(argv[++i]);
+            } else if (arg == "--phase" && has_value) {
+                string mode = argv[++i];
+                if (mode == "saved") {
+                    options.phase_mode = PhaseMode::SAVED;
+                } else if (mode == "false") {
+                    options.phase_mode = PhaseMode::ALWAYS_FALSE;
+                } else if (mode == "target") {
+                    options.phase_mode = PhaseMode::TARGET;
+                } else {
+                    throw invalid_argument(mode);
+                }
+            } else if (arg == "--rephase-interval" && has_value) {
+                options.rephase_interval = stoull(argv[++i]);
+            } else if (arg == "--restart" && has_value) {
+                string mode = argv[++i];
+                if (mode == "none") {
+                    options.restart_mode = RestartMode::NONE;
+                } else if (mode == "luby") {
+                    options.restart_mode = RestartMode::LUBY;
+                } else if (mode == "geometric") {
+                    options.restart_mode = RestartMode::GEOMETRIC;
+                } else if (mode == "glucose") {
+                    options.restart_mode = RestartMode::GLUCOSE;
+                } else {
+                    throw invalid_argument(mode);
+                }
+            } else if (arg == "--restart-base" && has_value) {
+                options.restart_base = stoull(argv[++i]);
+            } else if (arg == "--restart-factor" && has_value) {
+                options.restart_factor = stod(argv[++i]);
+            } else if (arg == "--reduce-interval" && has_value) {
+                options.reduce_interval = stoull(argv[++i]);
+            } else if (arg == "--chrono" && has_value) {
+                options.chrono = static_cast<unsigned>(stoul(argv[++i]));
+            } else if (arg == "--no-minimize") {
+                options.minimize_learned = false;
+            } else if (arg == "--no-preprocess") {
+                options.preprocess = false;
+            } else if (arg == "--no-probe") {
+                options.probe = false;
+            } else if (arg == "--no-inprocess") {
+                options.inprocess = false;
+            } else if (arg == "--no-walk") {
+                options.walk = false;
+            } else if (arg == "--no-share") {
+                options.share = false;
+            } else if (arg == "--cube-server" && has_value) {
+                unsigned long port = stoul(argv[++i]);
+                if (port == 0 || port > 65535) throw invalid_argument("port");
+                options.cube_port = static_cast<uint16_t>(port);
+            } else if (arg == "--cube-worker" && has_value) {
+                options.cube_server = argv[++i];
+            } else if (arg == "--cube-depth" && has_value) {
+                options.cube_depth = static_cast<unsigned>(stoul(argv[++i]));
+            } else if (arg == "--cube-conflicts" && has_value) {
+                options.cube_conflicts = stoull(argv[++i]);
+            } else if (arg == "--max-conflicts" && has_value) {
+                options.max_conflicts = stoull(argv[++i]);
+            } else if (arg == "--time-limit" && has_value) {
+                options.time_limit = stod(argv[++i]);
+            } else if (arg == "--mem-limit" && has_value) {
+                options.mem_limit = stoull(argv[++i]);
+            } else if (arg == "--model" && has_value) {
+                options.model_file = argv[++i];
+            } else if (arg == "--verify") {
+                options.verify = true;
+            } else if (arg == "--engine" && has_value) {
+                string engine = argv[++i];
+                if (engine == "full") {
+                    options.engine = Engine::FULL;
+                } else if (engine == "lean") {
+                    options.engine = Engine::LEAN;
+                } else {
+                    return false;
+                }
+            } else if (arg == "--proof" && has_value) {
+                options.proof_file = argv[++i];
+            } else if (arg == "--proof-format" && has_value) {
+                string format = argv[++i];
+                if (format == "binary") {
+                    options.proof_format = ProofFormat::DRAT_BINARY;
+                } else if (format == "text") {
+                    options.proof_format = ProofFormat::DRAT_TEXT;
+                } else if (format == "lrat") {
+                    options.proof_format = ProofFormat::LRAT;
+                } else {
+                    throw invalid_argument(format);
+                }
+            } else if (arg == "--progress" && has_value) {
+                options.progress = stod(argv[++i]);
+            } else if (arg == "--timers") {
+                options.timers = true;
+            } else if (arg == "--stats-json" && has_value) {
+                options.stats_file = argv[++i];
+            } else if (arg == "--snapshot" && has_value) {
+                options.snapshot_file = argv[++i];
+            } else if (arg == "--resume" && has_value) {
+                options.resume_file = argv[++i];
+            } else if (arg == "--bench" && has_value) {
+                options.bench = argv[++i];
+            } else if (arg == "--bench-timeout" && has_value) {
+                options.bench_timeout = stod(argv[++i]);
+                if (options.bench_timeout <= 0) throw invalid_argument("timeout");
+            } else if (arg == "--bench-memory" && has_value) {
+                options.bench_memory = stoull(argv[++i]);
+            } else if (arg == "--bench-output" && has_value) {
+                options.bench_output = argv[++i];
+            } else if (arg == "--baseline" && has_value) {
+                options.bench_baseline = argv[++i];
+            } else if (arg == "--batch" && has_value) {
+                options.batch = argv[++i];
+            } else if (arg == "--jobs" && has_value) {
+                options.jobs = static_cast<unsigned>(stoul(argv[++i]));
+            } else if (arg == "--batch-output" && has_value) {
+                options.batch_output = argv[++i];
+            } else if (arg == "--threads" && has_value) {
+                options.threads = static_cast<unsigned>(stoul(argv[++i]));
+                if (options.threads == 0) throw invalid_argument("threads");
+            } else if (arg.rfind("--", 0) == 0 || !filename.empty()) {
+                cout << "Unknown argument: " << arg << endl;
+                return false;
+            } else {
+                filename = arg;
+            }
+        } catch (const exception&) {
+            cout << "Invalid value for " << arg << ": " << argv[i] << endl;
+            return false;
+        }
+    }
+    return !filename.empty() || !options.bench.empty() || !options.batch.empty() || !options.resume_file.empty();
+}
+
+int main(int argc, char* argv[]) {
+    auto start = chrono::steady_clock::now();
+    SolverOptions options;
+    string filename;
+    if (!parse_arguments(argc, argv, options, filename)) {
+        cout << "Usage: " << argv[0] << " [--seed N] [--random-freq P] [--var-decay D] [--phase saved|false|target]"
+             << " [--rephase-interval N] [--restart none|luby|geometric|glucose] [--restart-base N]"
+             << " [--restart-factor F] [--reduce-interval N] [--no-minimize] [--chrono N]"
+             << " [--no-preprocess] [--no-probe] [--no-inprocess] [--no-walk] [--threads N] [--no-share]"
+             << " [--cube-server PORT | --cube-worker HOST:PORT] [--cube-depth N] [--cube-conflicts N]"
+             << " [--max-conflicts N] [--time-limit S] [--mem-limit MB] [--engine full|lean] [--model FILE] [--verify]"
+             << " [--proof FILE] [--proof-format binary|text|lrat] [--progress S] [--timers] [--stats-json FILE]"
+             << " [--snapshot FILE] file.cnf" << endl;
+        cout << "   or: " << argv[0] << " [options] [--snapshot FILE] --resume FILE" << endl;
+        cout << "   or: " << argv[0] << " [options] --bench DIR|LIST [--bench-timeout S] [--bench-memory MB]"
+             << " [--bench-output FILE.csv|FILE.json] [--baseline FILE]" << endl;
+        cout << "   or: " << argv[0] << " [options] --batch DIR|LIST [--jobs N] [--batch-output FILE.csv|FILE.json]"
+             << endl;
+        cout << "Please provide a DIMACS CNF filename as an argument." << endl;
+        return 1;
+    }
+    if (options.engine == Engine::LEAN &&
+        (options.restart_mode != RestartMode::GLUCOSE || !options.proof_file.empty() || options.progress > 0 ||
+         options.timers || options.threads > 1 || options.cube_port || !options.cube_server.empty())) {
+        cout << "The lean engine is a single solver with glucose restarts, without proofs, progress lines or timers."
+             << endl;
+        return 1;
+    }
+    signal(SIGUSR1, request_stats);
+    if ((!options.snapshot_file.empty() || !options.resume_file.empty()) &&
+        (options.threads > 1 || !options.proof_file.empty() || options.cube_port || !options.cube_server.empty() ||
+         !options.batch.empty() || !options.bench.empty())) {
+        cout << "Snapshots are written and resumed by a single solver: no --threads, proofs, cube-and-conquer,"
+             << " batches or benchmarks." << endl;
+        return 1;
+    }
+    if (!options.resume_file.empty() && (!filename.empty() || options.verify)) {
+        cout << "--resume takes the place of the CNF file, which leaves no input to --verify a model against." << endl;
+        return 1;
+    }
+    if (!options.batch.empty()) {
+        if (options.threads > 1 || options.mem_limit || !options.proof_file.empty() || options.cube_port ||
+            !options.cube_server.empty()) {
+            cout << "Batch mode runs one solver per instance in a shared process: no --threads, --mem-limit, proofs"
+                 << " or cube-and-conquer." << endl;
+            return 1;
+        }
+        signal(SIGINT, request_interrupt);
+        signal(SIGTERM, request_interrupt);
+        try {
+            return run_batch(options);
+        } catch (const runtime_error& e) {
+            cout << "Batch failed, " << e.what() << endl;
+            return 1;
+        }
+    }
+    if (!options.bench.empty()) {
+        try {
+            return run_bench(options);
+        } catch (const runtime_error& e) {
+            cout << "Benchmark failed, " << e.what() << endl;
+            return 1;
+        }
+    }
+
+    // A resumed solver fills the empty formula from the snapshot.
+    Formula formula;
+    try {
+        if (options.resume_file.empty()) {
+            unique_ptr<InputSource> input = open_input(filename);
+            if (!input) {
+                cout << "Unable to open the file: " << filename << endl;
+                return 1;
+            }
+            formula = parse_dimacs_cnf(*input);
+        }
+    } catch (const runtime_error& e) {
+        cout << "Error parsing " << filename << ", " << e.what() << endl;
+        return 1;
+    } catch (const bad_alloc&) {
+        cout << "Error parsing " << filename << ", out of memory" << endl;
+        return 1;
+    }
+    unique_ptr<Proof> proof;
+    if (!options.proof_file.empty()) {
+        if (options.threads > 1 || options.cube_port || !options.cube_server.empty()) {
+            cout << "A proof can only be written by a single solver, without --threads or cube-and-conquer." << endl;
+            return 1;
+        }
+        int fd = open(options.proof_file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            cout << "Unable to open the proof file: " << options.proof_file << endl;
+            return 1;
+        }
+        proof = make_unique<Proof>(fd, options.proof_format);
+    }
+    if (!options.cube_server.empty()) return run_cube_worker(formula, options);
+
+    // Solving simplifies formula in place, so verification needs a copy of the input.
+    optional<Formula> input;
+    if (options.verify) input = formula;
+    int max_variable = formula.max_variable;
+    signal(SIGINT, request_interrupt);
+    signal(SIGTERM, request_interrupt);
+    SolveResult result = UNKNOWN_RESULT;
+    if (proof) {
+        try {
+            result = cdcl_solve(formula, options, {}, nullptr, nullptr, 0, proof.get());
+            proof->flush();
+        } catch (const runtime_error& e) {
+            cout << "Writing the proof failed, " << e.what() << endl;
+            return 1;
+        }
+    } else if (options.cube_port) {
+        try {
+            result = serve_cubes(formula, options);
+        } catch (const runtime_error& e) {
+            cout << "Cube server failed, " << e.what() << endl;
+            return 1;
+        }
+    } else if (options.threads > 1) {
+        result = portfolio_solve(formula, options);
+    } else {
+        try {
+            result = engine_solve(formula, options);
+        } catch (const runtime_error& e) {
+            cout << "Snapshot failed, " << e.what() << endl;
+            return 1;
+        }
+        max_variable = formula.max_variable;  // known only now when resuming
+    }
+    if (!options.stats_file.empty()) {
+        try {
+            write_stats_json(options.stats_file, result, seconds_since(start));
+        } catch (const runtime_error& e) {
+            cout << "Writing the statistics failed, " << e.what() << endl;
+        }
+    }
+
+    return report_result(result, options, input ? &*input : nullptr, max_variable);
 }